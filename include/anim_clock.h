@@ -0,0 +1,40 @@
+#ifndef ANIM_CLOCK_H
+#define ANIM_CLOCK_H
+
+#include <stdbool.h>
+
+// Animation units per second; one unit per frame at 60 fps
+#define ANIMATION_SPEED 60.0f
+// Frame rate of every recording, interactive or batch; recording clocks step at exactly this rate
+#define RECORD_FPS 30
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum {
+    CLOCK_REALTIME,     // t follows wall time; late frames are skipped, not queued
+    CLOCK_FIXED_STEP    // t advances exactly 1/fps per produced frame, for recording
+} AnimClockMode;
+
+// Separates animation time from how often frames are presented. Interactive
+// playback keeps the same speed at any frame rate; recording produces frames
+// exactly on the encoder's time grid no matter how long each one takes.
+typedef struct {
+    AnimClockMode mode;
+    float speed;            // Animation units per second
+    double lastTime;        // Wall time of the last advance (realtime mode)
+    double startTime;       // Wall time fixed-step frame 0 was due
+    int fps;                // Fixed-step frame rate
+    long long frameIndex;   // Fixed-step frames produced so far
+} AnimClock;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+void AnimClock_Init(AnimClock *clock, float speed, double now);
+void AnimClock_StartRealtime(AnimClock *clock, double now);
+void AnimClock_StartFixedStep(AnimClock *clock, int fps, double now);
+void AnimClock_Resume(AnimClock *clock, double now);
+bool AnimClock_Advance(AnimClock *clock, double now, float *t);
+
+#endif // ANIM_CLOCK_H
@@ -0,0 +1,9 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+int RunBatch(int argc, char *argv[]);
+
+#endif // BATCH_H
@@ -0,0 +1,19 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "raylib.h"
+#include "recreation.h"
+
+// Worker thread that generates recreation frames into a lock-free triple buffer.
+// The main thread submits the parameters for the next frame and presents the
+// newest completed one, so generation overlaps with vsync and GPU work.
+// Only the frame side is lock-free: submitting a request takes a mutex for
+// one keyframe-line copy and wakes the sleeping worker with a condvar.
+typedef struct FramePipeline FramePipeline;
+
+FramePipeline *FramePipeline_Init(int width, int height);
+void FramePipeline_Submit(FramePipeline *pipeline, const Color *keyframe, RecreationParams params);
+const Color *FramePipeline_Acquire(FramePipeline *pipeline, RecreationParams *params);
+void FramePipeline_Exit(FramePipeline *pipeline);
+
+#endif // FRAME_PIPELINE_H
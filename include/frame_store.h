@@ -0,0 +1,23 @@
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Compressed store for recorded RGBA frames. Rows are deduplicated within a
+// frame and against any row of the previous frame, the rest are run or delta
+// coded.
+// Sealed segments spill to a temp file once in-memory data passes the
+// high-water mark. Frames are read back sequentially, one at a time.
+typedef struct FrameStore FrameStore;
+
+FrameStore *FrameStore_Init(int width, int height, size_t memoryHighWater);
+bool FrameStore_Append(FrameStore *store, Image frame);
+bool FrameStore_SetMemoryHighWater(FrameStore *store, size_t memoryHighWater);
+void FrameStore_PrintStats(const FrameStore *store);
+bool FrameStore_BeginRead(FrameStore *store);
+Image FrameStore_ReadNext(FrameStore *store);
+void FrameStore_Exit(FrameStore *store);
+
+#endif // FRAME_STORE_H
@@ -2,6 +2,7 @@
 #define GLOBALS_H
 
 #include "raylib.h"
+#include "anim_clock.h"
 
 //----------------------------------------------------------------------------------
 // Types and Structures Definition
@@ -13,6 +14,16 @@ typedef enum {
     CHANNEL_ORIGINAL
 } ActiveChannel;
 
+typedef enum {
+    SCAN_HORIZONTAL,    // Bar across a row, keyframe animated along X
+    SCAN_VERTICAL       // Bar down a column, keyframe animated along Y
+} ScanAxis;
+
+typedef enum {
+    RECORD_FORMAT_PNG,  // Captured screens, PNG sequence + ffmpeg
+    RECORD_FORMAT_Y4M   // Stripe frames streamed straight to a .y4m file
+} RecordFormat;
+
 typedef enum {
     VIEW_ANALYZER,
     VIEW_RECREATE,
@@ -20,8 +31,15 @@ typedef enum {
 } AppView;
 
 
-// Forward declaration
+// Forward declarations
 struct RecreateShaderView;
+struct FramePipeline;
+struct Y4mWriter;
+struct FrameStore;
+struct ShmOutput;
+struct IngestCache;
+struct KeyframeTimeline;
+struct RowScores;
 
 typedef struct {
     // Core Data
@@ -29,6 +47,9 @@ typedef struct {
     Image r_img;
     Image g_img;
     Image b_img;
+    Image transposed;   // Column-major copy of original for vertical scanlines
+    float *rowVariance; // Per-row R, G and B variances of original, summed over channels
+    struct IngestCache *ingestCache; // Non-NULL when the images above are mapped from the cache
 
     // Display Textures
     Texture2D tex_r;
@@ -53,13 +74,23 @@ typedef struct {
     AppView currentView;
     ActiveChannel currentChannel;
     bool manualControl;
+    ScanAxis scanAxis;
     float barY;
+    float barX;
     Vector2 lastMousePosition;
     double upKeyDownTime;
     double downKeyDownTime;
+    struct RowScores *rowScores;    // Background keyframe row ranking
+    int scoreRank;                  // Rank last jumped to with [N]/[B], -1 before the first jump
+    int selectedRow;                // Source row of that jump while the bar stays on it, else -1
 
     // Keyframe Data
-    Color *keyframe_pixels;
+    Color *keyframe_pixels;     // One row, or one column when keyframe_vertical
+    bool keyframe_vertical;
+    struct KeyframeTimeline *keyframeTimeline;  // Rows captured with [J], blended into keyframe_pixels
+    bool timelineComplete;      // Set by [K]; the next capture starts a new timeline
+    double timelineStartTime;   // Wall time of the timeline's first capture
+    float keyframeSpacing;      // Fixed time between keyframes, 0 to use capture times
     Image recreationImage;
     int z_offset;
     int stripe_height;
@@ -69,15 +100,30 @@ typedef struct {
     // Animation State
     bool animating;
     float t;
-    float dt;
+    AnimClock clock;    // Advances t; fixed-step while recording
+    bool captureDue;    // A recording frame is due this update
     Rectangle animateButton;
 
+    // Pipelined generation (worker thread + triple buffer)
+    bool pipelined;
+    bool resumePipelined;   // Pipelining paused for a screen-captured recording
+    struct FramePipeline *framePipeline;
+
     // Video Recording State
     bool recording;
     int frame_count;
     char recording_dir[256];
-    Image *frame_buffer;
-    int max_frames;
+    struct FrameStore *frameStore;
+    int max_frames;     // 0 means limited only by disk space
+    RecordFormat recordFormat;
+    struct Y4mWriter *y4mWriter;
+
+    // Shared-memory live output
+    const char *shmName;    // NULL when disabled
+    struct ShmOutput *shmOutput;
+
+    // Memory accounting
+    bool showMemoryOverlay;
 
     // Views
     struct RecreateShaderView *recreateShaderView;
@@ -0,0 +1,14 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include "raylib.h"
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+Image LoadCroppedImage(const char *filename, Rectangle *crop);
+Image TransposeImage(Image image);
+void ComputeRowVariance(Image image, float *variance);
+int FindMaxVarianceRow(Image image);
+
+#endif // INGEST_H
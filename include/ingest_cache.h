@@ -0,0 +1,44 @@
+#ifndef INGEST_CACHE_H
+#define INGEST_CACHE_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Identifies a source image. The cache file is named by a hash of sampled
+// blocks, so renamed or copied files still hit; the full content hash is only
+// computed when the modification time no longer matches, or when saving.
+typedef struct {
+    char path[512];
+    uint64_t size;
+    int64_t mtime;
+    uint64_t sampleHash;
+    uint64_t contentHash;
+    bool haveContentHash;
+} IngestCacheKey;
+
+// Everything InitApp derives from the source image
+typedef struct {
+    Rectangle crop;
+    Image original;
+    Image channels[3];      // R, G, B planes
+    Image transposed;
+    Image display[4];       // R, G, B and original at display size
+    float *rowVariance;     // One entry per row of original
+} IngestResult;
+
+// Memory-mapped cache file; images loaded from it point into the mapping
+typedef struct IngestCache IngestCache;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+bool IngestCache_ComputeKey(const char *sourcePath, IngestCacheKey *key);
+IngestCache *IngestCache_Load(IngestCacheKey *key, IngestResult *result);
+bool IngestCache_Save(IngestCacheKey *key, const IngestResult *result);
+void IngestCache_Close(IngestCache *cache);
+
+#endif // INGEST_CACHE_H
@@ -0,0 +1,29 @@
+#ifndef KEYFRAME_TIMELINE_H
+#define KEYFRAME_TIMELINE_H
+
+#include "raylib.h"
+#include <stdbool.h>
+
+typedef enum {
+  KEYFRAME_BLEND_CROSSFADE,   // Whole line fades from one keyframe to the next
+  KEYFRAME_BLEND_SWEEP        // A soft edge travels along the line, pixel by pixel
+} KeyframeBlendMode;
+
+// Sequence of captured scanlines placed at increasing animation times. Each
+// frame blends only the two neighbouring keyframe lines into one line, which
+// the stripe renderer then expands, so cost does not depend on frame size.
+// All lines share one axis and length; the timeline loops back to its first
+// keyframe over `loopSpacing` after the last.
+typedef struct KeyframeTimeline KeyframeTimeline;
+
+KeyframeTimeline *KeyframeTimeline_Init(int capacity, float loopSpacing);
+bool KeyframeTimeline_Matches(const KeyframeTimeline *timeline, int length, bool vertical);
+bool KeyframeTimeline_Append(KeyframeTimeline *timeline, const Color *scanline, int length, bool vertical, float time);
+void KeyframeTimeline_Clear(KeyframeTimeline *timeline);
+int KeyframeTimeline_Count(const KeyframeTimeline *timeline);
+void KeyframeTimeline_SetBlendMode(KeyframeTimeline *timeline, KeyframeBlendMode mode);
+KeyframeBlendMode KeyframeTimeline_GetBlendMode(const KeyframeTimeline *timeline);
+void KeyframeTimeline_Sample(KeyframeTimeline *timeline, float t, Color *out);
+void KeyframeTimeline_Exit(KeyframeTimeline *timeline);
+
+#endif // KEYFRAME_TIMELINE_H
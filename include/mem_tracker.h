@@ -0,0 +1,49 @@
+#ifndef MEM_TRACKER_H
+#define MEM_TRACKER_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum {
+    MEM_SOURCE,       // Cropped original image
+    MEM_CHANNELS,     // Per-channel R/G/B images
+    MEM_DISPLAY,      // Downscaled display images built at init
+    MEM_RECREATION,   // Recreation image and keyframe row
+    MEM_PIPELINE,     // Worker triple buffer
+    MEM_GPU,          // Textures and render targets (estimated)
+    MEM_FRAMES,       // Captured recording frames
+    MEM_SHARED,       // Shared-memory frame ring published to external readers
+    MEM_MAPPED,       // File mappings the kernel can evict (not counted against the budget)
+    MEM_CATEGORY_COUNT
+} MemCategory;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+// Heap allocations go through these so their size is counted where it is freed
+void *TrackedMalloc(MemCategory category, size_t size);
+void *TrackedCalloc(MemCategory category, size_t count, size_t size);
+void *TrackedRealloc(MemCategory category, void *ptr, size_t size);
+void TrackedFree(void *ptr);
+
+// Memory owned by raylib or the OS is reported explicitly
+void TrackBytes(MemCategory category, long long bytes);
+void TrackImage(MemCategory category, Image image);
+void UntrackImage(MemCategory category, Image image);
+void TrackTexture(Texture2D texture);
+void UntrackTexture(Texture2D texture);
+
+void SetMemoryBudget(size_t bytes);
+size_t GetMemoryBudget(void);
+bool MemoryBudgetAllows(size_t bytes);
+size_t GetTrackedBytes(MemCategory category);
+size_t GetTrackedTotal(void);
+
+void DrawMemoryOverlay(int posX, int posY);
+void ReportMemoryUsage(void);
+
+#endif // MEM_TRACKER_H
@@ -0,0 +1,35 @@
+#ifndef RECREATION_H
+#define RECREATION_H
+
+#include "raylib.h"
+#include <stdbool.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Everything needed to build one recreation frame from a keyframe line.
+// Horizontal keyframes are rows animated along X in horizontal stripes;
+// vertical keyframes are columns animated along Y in vertical stripes.
+typedef struct {
+    float t;
+    int z_offset;
+    int stripe_height;
+    bool animating;
+    bool vertical;
+} RecreationParams;
+
+// Keyframe mapping of one stripe line: source = (start + direction * pos) mod length
+typedef struct {
+    int start;
+    int direction;
+} RecreationRowMap;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+int GetRecreationKeyframeLength(RecreationParams params, int width, int height);
+RecreationRowMap GetRecreationRowMap(RecreationParams params, int length, int stripePos);
+void GetRecreationRowIndices(RecreationParams params, int width, int height, int y, int *indices);
+void GenerateRecreationFrame(const Color *keyframe, int width, int height, RecreationParams params, Color *out);
+
+#endif // RECREATION_H
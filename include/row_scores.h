@@ -0,0 +1,30 @@
+#ifndef ROW_SCORES_H
+#define ROW_SCORES_H
+
+#include "raylib.h"
+#include <stdbool.h>
+
+// How interesting one source row is as a keyframe. Each metric is scaled
+// to 0..1 by its maximum over the image; score is their weighted sum.
+typedef struct {
+  float variance;         // R, G and B variance, summed over channels
+  float edgeEnergy;       // Mean absolute difference between neighbouring pixels
+  float entropy;          // Shannon entropy of the 4-4-4 bit color histogram
+  float distinctColors;   // Occupied 4-4-4 histogram bins
+  float score;
+} RowScore;
+
+// Scores every row of an image on background threads. Once ready, rows are
+// ranked best-first with nearby rows suppressed, so stepping through the
+// ranking visits visibly different rows.
+typedef struct RowScores RowScores;
+
+RowScores *RowScores_Start(Image image, const float *rowVariance);
+bool RowScores_Ready(const RowScores *scores);
+float RowScores_Progress(const RowScores *scores);
+const RowScore *RowScores_Get(const RowScores *scores);
+int RowScores_RankCount(const RowScores *scores);
+int RowScores_RowAtRank(const RowScores *scores, int rank);
+void RowScores_Exit(RowScores *scores);
+
+#endif // ROW_SCORES_H
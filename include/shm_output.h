@@ -0,0 +1,14 @@
+#ifndef SHM_OUTPUT_H
+#define SHM_OUTPUT_H
+
+#include "raylib.h"
+
+// Publishes finished recreation frames into a POSIX shared-memory ring (see
+// shm_ring.h). Publishing never waits for readers.
+typedef struct ShmOutput ShmOutput;
+
+ShmOutput *ShmOutput_Open(const char *name, int width, int height, int slotCount);
+void ShmOutput_Publish(ShmOutput *output, const Color *pixels);
+void ShmOutput_Close(ShmOutput *output);
+
+#endif // SHM_OUTPUT_H
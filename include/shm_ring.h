@@ -0,0 +1,41 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Layout of the shared-memory frame ring published by `recreate --shm <name>`.
+// The mapping starts with a ShmRingHeader followed by slotCount slots, each a
+// ShmSlotHeader and the frame pixels, `slotStride` bytes apart.
+//
+// Each slot is a seqlock: the publisher makes `seq` odd, writes the frame,
+// then makes it even again. Readers read `seq`, use the pixels in place, and
+// re-read `seq`; if it changed or was odd, the frame was overwritten meanwhile.
+#define SHM_RING_MAGIC   0x474E5253u // "SRNG"
+#define SHM_RING_VERSION 1u
+#define SHM_FORMAT_RGBA8 1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint64_t frameBytes;
+    uint64_t slotStride;
+    uint64_t firstSlotOffset;
+    _Atomic uint64_t published;     // Frames published so far; newest is published - 1
+} ShmRingHeader;
+
+typedef struct {
+    _Atomic uint32_t seq;
+    uint32_t reserved;
+    uint64_t frameIndex;
+    uint64_t timestampNs;           // CLOCK_MONOTONIC at publish time
+    uint64_t size;
+} ShmSlotHeader;
+
+#define SHM_SLOT_PIXELS(slot) ((const unsigned char *)(slot) + sizeof(ShmSlotHeader))
+
+#endif // SHM_RING_H
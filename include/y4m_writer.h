@@ -0,0 +1,21 @@
+#ifndef Y4M_WRITER_H
+#define Y4M_WRITER_H
+
+#include "raylib.h"
+#include "recreation.h"
+#include <stdbool.h>
+
+// Streams planar YUV 4:2:0 frames to a .y4m file that any encoder can read.
+// Stripe frames are assembled from a keyframe line converted to YUV once;
+// arbitrary RGBA images go through a vectorized general conversion.
+typedef struct Y4mWriter Y4mWriter;
+
+Y4mWriter *Y4mWriter_Open(const char *path, int width, int height, int fps);
+void Y4mWriter_SetKeyframe(Y4mWriter *writer, const Color *keyframe, int length);
+void Y4mWriter_BuildStripeFrame(Y4mWriter *writer, RecreationParams params);
+bool Y4mWriter_WriteFrame(Y4mWriter *writer);
+bool Y4mWriter_WriteStripeFrame(Y4mWriter *writer, RecreationParams params);
+bool Y4mWriter_WriteImage(Y4mWriter *writer, Image image);
+void Y4mWriter_Close(Y4mWriter *writer);
+
+#endif // Y4M_WRITER_H
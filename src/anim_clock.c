@@ -0,0 +1,64 @@
+#include "anim_clock.h"
+
+// Longest wall-time gap one realtime advance may cover. Longer stalls (window
+// drags, breakpoints, returning from another view) resume instead of jumping.
+#define MAX_REALTIME_STEP 0.25
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+void AnimClock_Init(AnimClock *clock, float speed, double now)
+{
+    clock->speed = speed;
+    clock->fps = 0;
+    AnimClock_StartRealtime(clock, now);
+}
+
+void AnimClock_StartRealtime(AnimClock *clock, double now)
+{
+    clock->mode = CLOCK_REALTIME;
+    clock->lastTime = now;
+}
+
+void AnimClock_StartFixedStep(AnimClock *clock, int fps, double now)
+{
+    clock->mode = CLOCK_FIXED_STEP;
+    clock->fps = fps;
+    clock->startTime = now;
+    clock->frameIndex = 0;
+}
+
+// Call when animation restarts after a pause so the paused time is not played back
+void AnimClock_Resume(AnimClock *clock, double now)
+{
+    if (clock->mode == CLOCK_FIXED_STEP) {
+        clock->startTime = now - (double)clock->frameIndex / clock->fps;
+    } else {
+        clock->lastTime = now;
+    }
+}
+
+// Advances *t to wall time `now`. Returns false when no new frame is due, so
+// the caller can skip generating it entirely.
+bool AnimClock_Advance(AnimClock *clock, double now, float *t)
+{
+    if (clock->mode == CLOCK_FIXED_STEP) {
+        // Next frame on the fixed grid is not due yet
+        if ((now - clock->startTime) * clock->fps < (double)clock->frameIndex) return false;
+
+        // Under load, fall behind wall time rather than catching up in a burst
+        if ((now - clock->startTime) * clock->fps >= (double)(clock->frameIndex + 1)) {
+            clock->startTime = now - (double)clock->frameIndex / clock->fps;
+        }
+        clock->frameIndex++;
+        *t += clock->speed / clock->fps;
+        return true;
+    }
+
+    double elapsed = now - clock->lastTime;
+    clock->lastTime = now;
+    if (elapsed <= 0.0) return false;
+    if (elapsed > MAX_REALTIME_STEP) elapsed = MAX_REALTIME_STEP;
+    *t += (float)(elapsed * clock->speed);
+    return true;
+}
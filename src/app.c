@@ -1,62 +1,30 @@
 #include "app.h"
+#include "frame_pipeline.h"
+#include "frame_store.h"
+#include "ingest.h"
+#include "ingest_cache.h"
+#include "keyframe_timeline.h"
+#include "mem_tracker.h"
 #include "recreate_view_shader.h"
+#include "row_scores.h"
+#include "shm_output.h"
 #include "view_analyzer.h"
 #include "view_recreate.h"
+#include "y4m_writer.h"
 #include <stdlib.h> // For exit()
 #include <stdio.h>  // For snprintf
 #include <string.h> // For string functions
 
 //----------------------------------------------------------------------------------
-// Module Functions Definition
+// Module Local Functions Definition
 //----------------------------------------------------------------------------------
-void InitApp(AppState *state, const char *filename)
+// Fits the source image into the left render area
+static void CalculateLayout(AppState *state, int imageWidth, int imageHeight)
 {
-    state->original = LoadImage(filename);
-    if (state->original.data == NULL) {
-        // In a real app, you might want a more graceful exit
-        exit(1);
-    }
-
-    // Manual Crop
-    Color *pixels = LoadImageColors(state->original);
-    int left = state->original.width, right = 0, top = state->original.height, bottom = 0;
-    for (int y = 0; y < state->original.height; y++) {
-        for (int x = 0; x < state->original.width; x++) {
-            Color p = pixels[y * state->original.width + x];
-            if (p.r > 10 || p.g > 10 || p.b > 10) {
-                if (x < left)   left = x;
-                if (x > right)  right = x;
-                if (y < top)    top = y;
-                if (y > bottom) bottom = y;
-            }
-        }
-    }
-    if (left < right && top < bottom) {
-        Rectangle cropRec = { (float)left, (float)top, (float)(right - left + 1), (float)(bottom - top + 1) };
-        ImageCrop(&state->original, cropRec);
-        pixels = LoadImageColors(state->original);
-    }
-
-    // Prepare color channels
-    Color *r_pixels = (Color *)malloc(state->original.width * state->original.height * sizeof(Color));
-    Color *g_pixels = (Color *)malloc(state->original.width * state->original.height * sizeof(Color));
-    Color *b_pixels = (Color *)malloc(state->original.width * state->original.height * sizeof(Color));
-    for (int i = 0; i < state->original.width * state->original.height; i++) {
-        r_pixels[i] = (Color){ pixels[i].r, 0, 0, 255 };
-        g_pixels[i] = (Color){ 0, pixels[i].g, 0, 255 };
-        b_pixels[i] = (Color){ 0, 0, pixels[i].b, 255 };
-    }
-    UnloadImageColors(pixels);
-
-    state->r_img = (Image){ r_pixels, state->original.width, state->original.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
-    state->g_img = (Image){ g_pixels, state->original.width, state->original.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
-    state->b_img = (Image){ b_pixels, state->original.width, state->original.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
-
-    // Calculate layout
     const int screenHeight = 800;
     const int renderAreaWidth = 1000;
     const int renderAreaHeight = 800;
-    float aspectRatio = (float)state->original.width / (float)state->original.height;
+    float aspectRatio = (float)imageWidth / (float)imageHeight;
     int fitWidth, fitHeight;
     if ((renderAreaWidth / aspectRatio) <= renderAreaHeight) {
         fitWidth = renderAreaWidth;
@@ -69,12 +37,96 @@ void InitApp(AppState *state, const char *filename)
     state->finalHeight = (int)(fitHeight * 0.8f);
     state->posX = 0;
     state->posY = (screenHeight - state->finalHeight) / 2;
+}
 
-    // Create display images and textures
-    Image r_disp = ImageCopy(state->r_img); ImageResize(&r_disp, state->finalWidth, state->finalHeight); state->tex_r = LoadTextureFromImage(r_disp); UnloadImage(r_disp);
-    Image g_disp = ImageCopy(state->g_img); ImageResize(&g_disp, state->finalWidth, state->finalHeight); state->tex_g = LoadTextureFromImage(g_disp); UnloadImage(g_disp);
-    Image b_disp = ImageCopy(state->b_img); ImageResize(&b_disp, state->finalWidth, state->finalHeight); state->tex_b = LoadTextureFromImage(b_disp); UnloadImage(b_disp);
-    Image o_disp = ImageCopy(state->original); ImageResize(&o_disp, state->finalWidth, state->finalHeight); state->tex_original = LoadTextureFromImage(o_disp); UnloadImage(o_disp);
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+void InitApp(AppState *state, const char *filename)
+{
+    // Memory budget in MB; recording spills to disk and then stops before the machine starts swapping
+    const char *budgetEnv = getenv("RECREATE_MEM_BUDGET_MB");
+    size_t budgetMB = (budgetEnv != NULL) ? (size_t)strtoul(budgetEnv, NULL, 10) : 2048;
+    SetMemoryBudget(budgetMB * 1024 * 1024);
+
+    // Reuse the decoded, cropped and downscaled planes from a previous launch if we can
+    IngestCacheKey cacheKey;
+    bool haveKey = IngestCache_ComputeKey(filename, &cacheKey);
+    IngestResult ingest = { 0 };
+    state->ingestCache = haveKey ? IngestCache_Load(&cacheKey, &ingest) : NULL;
+    if (state->ingestCache != NULL) {
+        CalculateLayout(state, ingest.original.width, ingest.original.height);
+        if (ingest.display[0].width != state->finalWidth || ingest.display[0].height != state->finalHeight) {
+            // Layout constants changed since the cache was written
+            IngestCache_Close(state->ingestCache);
+            state->ingestCache = NULL;
+        }
+    }
+
+    if (state->ingestCache == NULL) {
+        ingest.original = LoadCroppedImage(filename, &ingest.crop);
+        if (ingest.original.data == NULL) {
+            // In a real app, you might want a more graceful exit
+            exit(1);
+        }
+
+        // Prepare color channels
+        Color *pixels = (Color *)ingest.original.data;
+        TrackImage(MEM_SOURCE, ingest.original);
+        Color *r_pixels = (Color *)TrackedMalloc(MEM_CHANNELS, ingest.original.width * ingest.original.height * sizeof(Color));
+        Color *g_pixels = (Color *)TrackedMalloc(MEM_CHANNELS, ingest.original.width * ingest.original.height * sizeof(Color));
+        Color *b_pixels = (Color *)TrackedMalloc(MEM_CHANNELS, ingest.original.width * ingest.original.height * sizeof(Color));
+        for (int i = 0; i < ingest.original.width * ingest.original.height; i++) {
+            r_pixels[i] = (Color){ pixels[i].r, 0, 0, 255 };
+            g_pixels[i] = (Color){ 0, pixels[i].g, 0, 255 };
+            b_pixels[i] = (Color){ 0, 0, pixels[i].b, 255 };
+        }
+        ingest.channels[0] = (Image){ r_pixels, ingest.original.width, ingest.original.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        ingest.channels[1] = (Image){ g_pixels, ingest.original.width, ingest.original.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        ingest.channels[2] = (Image){ b_pixels, ingest.original.width, ingest.original.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+
+        // Column-major copy so vertical scanlines read contiguous memory
+        ingest.transposed = TransposeImage(ingest.original);
+
+        ingest.rowVariance = (float *)TrackedMalloc(MEM_SOURCE, ingest.original.height * sizeof(float));
+        ComputeRowVariance(ingest.original, ingest.rowVariance);
+
+        // Create display images
+        CalculateLayout(state, ingest.original.width, ingest.original.height);
+        for (int i = 0; i < 3; i++) {
+            ingest.display[i] = ImageCopy(ingest.channels[i]);
+            ImageResize(&ingest.display[i], state->finalWidth, state->finalHeight);
+            TrackImage(MEM_DISPLAY, ingest.display[i]);
+        }
+        ingest.display[3] = ImageCopy(ingest.original);
+        ImageResize(&ingest.display[3], state->finalWidth, state->finalHeight);
+        TrackImage(MEM_DISPLAY, ingest.display[3]);
+
+        if (haveKey && !IngestCache_Save(&cacheKey, &ingest)) {
+            printf("Could not write ingest cache for %s\n", filename);
+        }
+    }
+
+    state->original = ingest.original;
+    state->r_img = ingest.channels[0];
+    state->g_img = ingest.channels[1];
+    state->b_img = ingest.channels[2];
+    state->transposed = ingest.transposed;
+    state->rowVariance = ingest.rowVariance;
+
+    // Rank keyframe rows in the background while the UI starts up
+    state->rowScores = RowScores_Start(state->original, state->rowVariance);
+    state->scoreRank = -1;
+    state->selectedRow = -1;
+
+    // Create display textures
+    state->tex_r = LoadTextureFromImage(ingest.display[0]); TrackTexture(state->tex_r);
+    state->tex_g = LoadTextureFromImage(ingest.display[1]); TrackTexture(state->tex_g);
+    state->tex_b = LoadTextureFromImage(ingest.display[2]); TrackTexture(state->tex_b);
+    state->tex_original = LoadTextureFromImage(ingest.display[3]); TrackTexture(state->tex_original);
+    if (state->ingestCache == NULL) {
+        for (int i = 0; i < 4; i++) { UntrackImage(MEM_DISPLAY, ingest.display[i]); UnloadImage(ingest.display[i]); }
+    }
 
     // Init UI and State
     state->plotArea = (Rectangle){ (float)state->finalWidth + 50, (float)state->posY, (float)1400 - state->finalWidth - 50, (float)state->finalHeight };
@@ -86,21 +138,47 @@ void InitApp(AppState *state, const char *filename)
     state->currentChannel = CHANNEL_R;
     state->currentView = VIEW_ANALYZER;
     state->lastMousePosition = (Vector2){ -1.0f, -1.0f };
-    state->keyframe_pixels = (Color *)malloc(state->original.width * sizeof(Color));
+    int keyframeCapacity = (state->original.width > state->original.height) ? state->original.width : state->original.height;
+    state->keyframe_pixels = (Color *)TrackedMalloc(MEM_RECREATION, keyframeCapacity * sizeof(Color));
+    state->keyframe_vertical = false;
+    // Timeline keyframes play back at the pace they were captured at, unless
+    // a fixed animation time between them is set. The loop back to the first
+    // keyframe takes the fixed spacing, or two seconds.
+    const char *spacingEnv = getenv("RECREATE_KEYFRAME_SPACING");
+    state->keyframeSpacing = (spacingEnv != NULL) ? strtof(spacingEnv, NULL) : 0.0f;
+    if (state->keyframeSpacing < 0.0f) state->keyframeSpacing = 0.0f;
+    state->keyframeTimeline = KeyframeTimeline_Init(keyframeCapacity, (state->keyframeSpacing > 0.0f) ? state->keyframeSpacing : 120.0f);
+    state->timelineComplete = false;
+    state->timelineStartTime = 0.0;
+    state->scanAxis = SCAN_HORIZONTAL;
     state->recreationImage = GenImageColor(state->original.width, state->original.height, BLACK);
+    TrackImage(MEM_RECREATION, state->recreationImage);
     state->z_offset = 0;
     state->stripe_height = 100; // Default stripe height
     state->animating = true;
     state->t = 0.0f;
-    state->dt = 1.0f;
+    AnimClock_Init(&state->clock, ANIMATION_SPEED, GetTime());
+    state->captureDue = false;
+    state->pipelined = false;
+    state->resumePipelined = false;
+    state->showMemoryOverlay = false;
+    state->framePipeline = NULL;
 
     // Initialize video recording state
     state->recording = false;
     state->frame_count = 0;
-    state->max_frames = 3000; // Max 3000 frames (about 2 minutes at 30fps)
-    state->frame_buffer = NULL;
+    state->max_frames = 0; // Unlimited, frames are compressed and spill to disk
+    state->frameStore = NULL;
+    state->recordFormat = RECORD_FORMAT_PNG;
+    state->y4mWriter = NULL;
     snprintf(state->recording_dir, sizeof(state->recording_dir), "video_frames");
 
+    // Live output for local consumers
+    state->shmOutput = NULL;
+    if (state->shmName != NULL) {
+        state->shmOutput = ShmOutput_Open(state->shmName, state->recreationImage.width, state->recreationImage.height, 4);
+    }
+
     state->recreateShaderView = RecreateShaderView_Init(state);
 }
 
@@ -112,6 +190,9 @@ void RunApp(AppState *state)
             state->currentView = VIEW_RECREATE_SHADER;
             SetWindowSize(1000, 800);
         }
+        if (IsKeyPressed(KEY_F3)) {
+            state->showMemoryOverlay = !state->showMemoryOverlay;
+        }
 
         switch (state->currentView) {
             case VIEW_ANALYZER:
@@ -133,23 +214,31 @@ void RunApp(AppState *state)
 void CleanupApp(AppState *state)
 {
     RecreateShaderView_Exit(state->recreateShaderView);
-    if (state->recreationTexture.id > 0) UnloadTexture(state->recreationTexture);
-    free(state->keyframe_pixels);
-    UnloadTexture(state->tex_r);
-    UnloadTexture(state->tex_g);
-    UnloadTexture(state->tex_b);
-    UnloadTexture(state->tex_original);
-    UnloadImage(state->original);
-    free(state->r_img.data);
-    free(state->g_img.data);
-    free(state->b_img.data);
-    UnloadImage(state->recreationImage);
+    RowScores_Exit(state->rowScores); // Stops scoring before the source image goes away
+    FramePipeline_Exit(state->framePipeline);
+    if (state->recreationTexture.id > 0) { UntrackTexture(state->recreationTexture); UnloadTexture(state->recreationTexture); }
+    TrackedFree(state->keyframe_pixels);
+    KeyframeTimeline_Exit(state->keyframeTimeline);
+    UntrackTexture(state->tex_r); UnloadTexture(state->tex_r);
+    UntrackTexture(state->tex_g); UnloadTexture(state->tex_g);
+    UntrackTexture(state->tex_b); UnloadTexture(state->tex_b);
+    UntrackTexture(state->tex_original); UnloadTexture(state->tex_original);
+    if (state->ingestCache != NULL) {
+        IngestCache_Close(state->ingestCache); // Owns every image above
+    } else {
+        UntrackImage(MEM_SOURCE, state->original); UnloadImage(state->original);
+        TrackedFree(state->transposed.data);
+        TrackedFree(state->r_img.data);
+        TrackedFree(state->g_img.data);
+        TrackedFree(state->b_img.data);
+        TrackedFree(state->rowVariance);
+    }
+    UntrackImage(MEM_RECREATION, state->recreationImage); UnloadImage(state->recreationImage);
     
     // Cleanup video recording resources
-    if (state->frame_buffer) {
-        for (int i = 0; i < state->frame_count; i++) {
-            UnloadImage(state->frame_buffer[i]);
-        }
-        free(state->frame_buffer);
-    }
+    Y4mWriter_Close(state->y4mWriter);
+    FrameStore_Exit(state->frameStore);
+    ShmOutput_Close(state->shmOutput);
+
+    ReportMemoryUsage();
 }
@@ -0,0 +1,373 @@
+#include "batch.h"
+#include "anim_clock.h"
+#include "ingest.h"
+#include "mem_tracker.h"
+#include "recreation.h"
+#include "y4m_writer.h"
+#include "raylib.h"
+#include <limits.h> // For INT_MAX
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h> // For sysconf
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct {
+    const char *outputDir;
+    int fixedRow;           // -1 selects the row with maximum variance
+    int frames;
+    int stripeHeight;
+    int jobs;
+    bool video;
+    bool y4m;
+} BatchOptions;
+
+typedef struct {
+    char path[512];
+    char name[256];
+    bool ok;
+    int width;
+    int height;
+    int row;
+    double ingestTime;
+    double keyframeTime;
+    double renderTime;
+    double writeTime;
+} BatchJob;
+
+typedef struct {
+    const BatchOptions *options;
+    BatchJob *jobs;
+    int jobCount;
+    atomic_int nextJob;
+} BatchQueue;
+
+//----------------------------------------------------------------------------------
+// Module Local Functions Definition
+//----------------------------------------------------------------------------------
+static double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Animation time of output frame i, on the same fixed step as interactive recording
+static float BatchFrameTime(int frame)
+{
+    return frame * (ANIMATION_SPEED / RECORD_FPS);
+}
+
+// ExportImage() matches the file type with raylib's shared text buffers; encode
+// to memory with the bundled stb_image_write instead, which is reentrant
+static bool ExportFramePNG(Image frame, const char *filename)
+{
+    int size = 0;
+    unsigned char *png = ExportImageToMemory(frame, ".png", &size);
+    if (png == NULL) return false;
+    bool saved = SaveFileData(filename, png, size);
+    MemFree(png);
+    return saved;
+}
+
+static int DefaultJobCount(void)
+{
+#ifdef _WIN32
+    const char *cpus = getenv("NUMBER_OF_PROCESSORS");
+    int count = (cpus != NULL) ? atoi(cpus) : 1;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return (count > 0) ? count : 1;
+}
+
+// Shell-style match supporting '*' and '?'
+static bool WildcardMatch(const char *pattern, const char *text)
+{
+    if (*pattern == '\0') return *text == '\0';
+    if (*pattern == '*') return WildcardMatch(pattern + 1, text) || (*text != '\0' && WildcardMatch(pattern, text + 1));
+    if (*text == '\0') return false;
+    if (*pattern == '?' || *pattern == *text) return WildcardMatch(pattern + 1, text + 1);
+    return false;
+}
+
+static int ComparePaths(const void *a, const void *b)
+{
+    return strcmp(((const BatchJob *)a)->path, ((const BatchJob *)b)->path);
+}
+
+// Expands a directory or a glob such as "assets/TARGET*.png" into a sorted job list
+static BatchJob *CollectJobs(const char *input, int *count)
+{
+    char directory[512];
+    const char *pattern = "*";
+    bool filterImages = false;
+
+    if (DirectoryExists(input)) {
+        snprintf(directory, sizeof(directory), "%s", input);
+        filterImages = true;
+    } else {
+        const char *slash = strrchr(input, '/');
+        if (slash != NULL) {
+            snprintf(directory, sizeof(directory), "%.*s", (int)(slash - input), input);
+            pattern = slash + 1;
+        } else {
+            snprintf(directory, sizeof(directory), ".");
+            pattern = input;
+        }
+    }
+
+    FilePathList files = LoadDirectoryFilesEx(directory, filterImages ? ".png;.jpg;.jpeg;.bmp;.tga" : NULL, false);
+    BatchJob *jobs = calloc(files.count > 0 ? files.count : 1, sizeof(BatchJob));
+    *count = 0;
+    for (unsigned int i = 0; i < files.count; i++) {
+        if (!IsPathFile(files.paths[i]) || !WildcardMatch(pattern, GetFileName(files.paths[i]))) continue;
+        BatchJob *job = &jobs[(*count)++];
+        snprintf(job->path, sizeof(job->path), "%s", files.paths[i]);
+        // Keep the extension so a.png and a.jpg get separate outputs
+        snprintf(job->name, sizeof(job->name), "%s", GetFileName(files.paths[i]));
+    }
+    UnloadDirectoryFiles(files);
+
+    qsort(jobs, *count, sizeof(BatchJob), ComparePaths);
+    return jobs;
+}
+
+static void ProcessJob(const BatchOptions *options, BatchJob *job)
+{
+    // Decode, render and encode all run on this worker's own buffers, so
+    // workers never wait on each other
+    double start = NowSeconds();
+    Image source = LoadCroppedImage(job->path, NULL);
+    if (source.data != NULL) TrackImage(MEM_SOURCE, source);
+    if (source.data == NULL) {
+        printf("[batch] %s: failed to load\n", job->name);
+        return;
+    }
+    job->width = source.width;
+    job->height = source.height;
+    double ingestDone = NowSeconds();
+
+    // Keyframe row
+    job->row = (options->fixedRow >= 0) ? options->fixedRow : FindMaxVarianceRow(source);
+    if (job->row >= source.height) job->row = source.height - 1;
+    Color *keyframe = TrackedMalloc(MEM_RECREATION, source.width * sizeof(Color));
+    if (keyframe != NULL) memcpy(keyframe, (Color *)source.data + (size_t)job->row * source.width, source.width * sizeof(Color));
+    UntrackImage(MEM_SOURCE, source);
+    UnloadImage(source);
+    if (keyframe == NULL) {
+        printf("[batch] %s: out of memory\n", job->name);
+        return;
+    }
+    double keyframeDone = NowSeconds();
+
+    // Render and write frames
+    bool written = true;
+    if (options->y4m) {
+        // Frames are assembled straight in YUV from the converted keyframe row
+        char filename[1024];
+        snprintf(filename, sizeof(filename), "%s/%s.y4m", options->outputDir, job->name);
+        double openStart = NowSeconds();
+        Y4mWriter *writer = Y4mWriter_Open(filename, job->width, job->height, RECORD_FPS);
+        written = (writer != NULL);
+        job->writeTime += NowSeconds() - openStart;
+        if (writer) {
+            double renderStart = NowSeconds();
+            Y4mWriter_SetKeyframe(writer, keyframe, job->width);
+            job->renderTime += NowSeconds() - renderStart;
+            for (int i = 0; i < options->frames && written; i++) {
+                RecreationParams params = { BatchFrameTime(i), 0, options->stripeHeight, true, false };
+                renderStart = NowSeconds();
+                Y4mWriter_BuildStripeFrame(writer, params);
+                double renderEnd = NowSeconds();
+                written = Y4mWriter_WriteFrame(writer);
+                job->renderTime += renderEnd - renderStart;
+                job->writeTime += NowSeconds() - renderEnd;
+            }
+            double closeStart = NowSeconds();
+            Y4mWriter_Close(writer);
+            job->writeTime += NowSeconds() - closeStart;
+        }
+    } else {
+        // The frame directory was created by RunBatch before the workers started
+        char frameDir[768];
+        snprintf(frameDir, sizeof(frameDir), "%s/%s", options->outputDir, job->name);
+
+        Color *pixels = TrackedMalloc(MEM_RECREATION, (size_t)job->width * job->height * sizeof(Color));
+        Image frame = { pixels, job->width, job->height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        written = (pixels != NULL);
+        for (int i = 0; i < options->frames && written; i++) {
+            RecreationParams params = { BatchFrameTime(i), 0, options->stripeHeight, true, false };
+            double renderStart = NowSeconds();
+            GenerateRecreationFrame(keyframe, frame.width, frame.height, params, (Color *)frame.data);
+            double renderEnd = NowSeconds();
+
+            char filename[1024];
+            snprintf(filename, sizeof(filename), "%s/frame_%06d.png", frameDir, i);
+            written = ExportFramePNG(frame, filename);
+            job->renderTime += renderEnd - renderStart;
+            job->writeTime += NowSeconds() - renderEnd;
+        }
+        TrackedFree(pixels);
+    }
+    TrackedFree(keyframe);
+
+    if (written && options->video) {
+        double encodeStart = NowSeconds();
+        char ffmpeg_cmd[2048];
+        if (options->y4m) {
+            snprintf(ffmpeg_cmd, sizeof(ffmpeg_cmd),
+                "ffmpeg -loglevel error -y -i %s/%s.y4m -c:v libx264 -crf 18 %s/%s.mp4",
+                options->outputDir, job->name, options->outputDir, job->name);
+        } else {
+            snprintf(ffmpeg_cmd, sizeof(ffmpeg_cmd),
+                "ffmpeg -loglevel error -y -framerate %d -i %s/%s/frame_%%06d.png -c:v libx264 -pix_fmt yuv420p -crf 18 %s/%s.mp4",
+                RECORD_FPS, options->outputDir, job->name, options->outputDir, job->name);
+        }
+        written = (system(ffmpeg_cmd) == 0);
+        job->writeTime += NowSeconds() - encodeStart;
+    }
+
+    job->ingestTime = ingestDone - start;
+    job->keyframeTime = keyframeDone - ingestDone;
+    job->ok = written;
+    printf("[batch] %-24s %5dx%-5d row %5d  ingest %6.3fs  keyframe %6.3fs  render %6.3fs  write %7.3fs%s\n",
+           job->name, job->width, job->height, job->row, job->ingestTime, job->keyframeTime,
+           job->renderTime, job->writeTime, job->ok ? "" : "  FAILED");
+}
+
+static void *BatchWorker(void *arg)
+{
+    BatchQueue *queue = arg;
+    for (;;) {
+        int index = atomic_fetch_add(&queue->nextJob, 1);
+        if (index >= queue->jobCount) break;
+        ProcessJob(queue->options, &queue->jobs[index]);
+    }
+    return NULL;
+}
+
+static void PrintBatchUsage(void)
+{
+    printf("Usage: recreate --batch <directory|glob> [options]\n");
+    printf("  --row <N|max-variance>  Keyframe row selection (default: max-variance)\n");
+    printf("  --frames <N>            Frames to render per image (default: 90)\n");
+    printf("  --stripe <N>            Stripe height in pixels (default: 100)\n");
+    printf("  --jobs <N>              Images processed in parallel (default: CPU count)\n");
+    printf("  --out <directory>       Output directory (default: batch_output)\n");
+    printf("  --format <png|y4m>      Write PNG frames or a single Y4M video per image (default: png)\n");
+    printf("  --video                 Encode each frame sequence to MP4 with ffmpeg\n");
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Headless batch mode: argv holds the arguments that follow "--batch"
+int RunBatch(int argc, char *argv[])
+{
+    if (argc < 1) {
+        PrintBatchUsage();
+        return 1;
+    }
+
+    BatchOptions options = { "batch_output", -1, 90, 100, DefaultJobCount(), false, false };
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--row") == 0 && hasValue) {
+            i++;
+            if (strcmp(argv[i], "max-variance") == 0) {
+                options.fixedRow = -1;
+            } else {
+                char *end = NULL;
+                long row = strtol(argv[i], &end, 10);
+                if (end == argv[i] || *end != '\0' || row < 0 || row > INT_MAX) {
+                    printf("Invalid --row value: %s\n", argv[i]);
+                    PrintBatchUsage();
+                    return 1;
+                }
+                options.fixedRow = (int)row;
+            }
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue) options.frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--stripe") == 0 && hasValue) options.stripeHeight = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--jobs") == 0 && hasValue) options.jobs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && hasValue) options.outputDir = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0 && hasValue) {
+            i++;
+            if (strcmp(argv[i], "png") != 0 && strcmp(argv[i], "y4m") != 0) {
+                printf("Unknown --format value: %s\n", argv[i]);
+                PrintBatchUsage();
+                return 1;
+            }
+            options.y4m = (strcmp(argv[i], "y4m") == 0);
+        }
+        else if (strcmp(argv[i], "--video") == 0) options.video = true;
+        else {
+            printf("Unknown batch option: %s\n", argv[i]);
+            PrintBatchUsage();
+            return 1;
+        }
+    }
+    if (options.frames < 1) options.frames = 1;
+    if (options.stripeHeight < 1) options.stripeHeight = 1;
+    if (options.jobs < 1) options.jobs = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    BatchQueue queue = { &options, NULL, 0, 0 };
+    queue.jobs = CollectJobs(argv[0], &queue.jobCount);
+    if (queue.jobCount == 0) {
+        printf("No images matched %s\n", argv[0]);
+        free(queue.jobs);
+        return 1;
+    }
+    if (options.jobs > queue.jobCount) options.jobs = queue.jobCount;
+    MakeDirectory(options.outputDir);
+    if (!options.y4m) {
+        for (int i = 0; i < queue.jobCount; i++) {
+            MakeDirectory(TextFormat("%s/%s", options.outputDir, queue.jobs[i].name));
+        }
+    }
+
+    printf("Processing %d images with %d workers...\n", queue.jobCount, options.jobs);
+    double start = NowSeconds();
+
+    pthread_t *workers = malloc(options.jobs * sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; i < options.jobs; i++) {
+        if (pthread_create(&workers[started], NULL, BatchWorker, &queue) == 0) started++;
+    }
+    if (started == 0) BatchWorker(&queue);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    free(workers);
+
+    double elapsed = NowSeconds() - start;
+
+    // Summary report
+    int succeeded = 0;
+    double ingest = 0.0, keyframe = 0.0, render = 0.0, write = 0.0;
+    for (int i = 0; i < queue.jobCount; i++) {
+        BatchJob *job = &queue.jobs[i];
+        if (job->ok) succeeded++;
+        ingest += job->ingestTime; keyframe += job->keyframeTime; render += job->renderTime; write += job->writeTime;
+    }
+    printf("\nBatch summary\n");
+    printf("  Images:      %d ok, %d failed\n", succeeded, queue.jobCount - succeeded);
+    printf("  Workers:     %d\n", options.jobs);
+    printf("  Wall time:   %.3fs (%.2f images/s, %.1f frames/s)\n", elapsed,
+           queue.jobCount / elapsed, (double)succeeded * options.frames / elapsed);
+    printf("  Stage time:  ingest %.3fs, keyframe %.3fs, render %.3fs, write %.3fs (summed over workers)\n",
+           ingest, keyframe, render, write);
+    ReportMemoryUsage();
+
+    free(queue.jobs);
+    return (succeeded == queue.jobCount) ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include "frame_pipeline.h"
+#include "mem_tracker.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The shared "middle" slot holds a buffer index plus a flag telling the
+// consumer that it was published since the last acquire.
+#define SLOT_INDEX_MASK 0x3
+#define SLOT_FRESH      0x4
+
+struct FramePipeline {
+  int width;
+  int height;
+  int keyframeCapacity;
+
+  // Triple buffer: worker owns back, main thread owns front, middle is shared
+  Color *buffers[3];
+  RecreationParams frameParams[3];
+  atomic_int middle;
+  int back;
+  int front;
+
+  // Latest request from the main thread. This side is a plain mutex and
+  // condvar so the idle worker sleeps; it is held only for one line memcpy.
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  Color *requestKeyframe;
+  RecreationParams requestParams;
+  unsigned long requestSeq;
+  unsigned long doneSeq;
+  bool quit;
+
+  Color *workerKeyframe;  // Worker's private copy of the requested keyframe
+  pthread_t thread;
+};
+
+static void *FramePipeline_Worker(void *arg) {
+  FramePipeline *pipeline = arg;
+  Color *keyframe = pipeline->workerKeyframe;
+
+  for (;;) {
+    pthread_mutex_lock(&pipeline->lock);
+    while (!pipeline->quit && pipeline->requestSeq == pipeline->doneSeq) {
+      pthread_cond_wait(&pipeline->wake, &pipeline->lock);
+    }
+    if (pipeline->quit) {
+      pthread_mutex_unlock(&pipeline->lock);
+      break;
+    }
+    // Only the newest request matters; anything older is skipped
+    RecreationParams params = pipeline->requestParams;
+    memcpy(keyframe, pipeline->requestKeyframe, pipeline->keyframeCapacity * sizeof(Color));
+    pipeline->doneSeq = pipeline->requestSeq;
+    pthread_mutex_unlock(&pipeline->lock);
+
+    GenerateRecreationFrame(keyframe, pipeline->width, pipeline->height, params, pipeline->buffers[pipeline->back]);
+    pipeline->frameParams[pipeline->back] = params;
+
+    int previous = atomic_exchange(&pipeline->middle, pipeline->back | SLOT_FRESH);
+    pipeline->back = previous & SLOT_INDEX_MASK;
+  }
+
+  return NULL;
+}
+
+// Frees everything Init allocated; safe on a partially initialized pipeline
+static void FramePipeline_FreeBuffers(FramePipeline *pipeline) {
+  for (int i = 0; i < 3; i++) {
+    TrackedFree(pipeline->buffers[i]);
+  }
+  TrackedFree(pipeline->requestKeyframe);
+  TrackedFree(pipeline->workerKeyframe);
+  free(pipeline);
+}
+
+FramePipeline *FramePipeline_Init(int width, int height) {
+  FramePipeline *pipeline = calloc(1, sizeof(FramePipeline));
+  if (pipeline == NULL) {
+    return NULL;
+  }
+
+  pipeline->width = width;
+  pipeline->height = height;
+  bool allocated = true;
+  for (int i = 0; i < 3; i++) {
+    pipeline->buffers[i] = TrackedCalloc(MEM_PIPELINE, (size_t)width * height, sizeof(Color));
+    allocated = allocated && (pipeline->buffers[i] != NULL);
+  }
+  pipeline->keyframeCapacity = (width > height) ? width : height;
+  pipeline->requestKeyframe = TrackedCalloc(MEM_PIPELINE, pipeline->keyframeCapacity, sizeof(Color));
+  pipeline->workerKeyframe = TrackedCalloc(MEM_PIPELINE, pipeline->keyframeCapacity, sizeof(Color));
+  if (!allocated || pipeline->requestKeyframe == NULL || pipeline->workerKeyframe == NULL) {
+    FramePipeline_FreeBuffers(pipeline);
+    return NULL;
+  }
+  pipeline->front = 0;
+  atomic_init(&pipeline->middle, 1);
+  pipeline->back = 2;
+
+  pthread_mutex_init(&pipeline->lock, NULL);
+  pthread_cond_init(&pipeline->wake, NULL);
+  if (pthread_create(&pipeline->thread, NULL, FramePipeline_Worker, pipeline) != 0) {
+    pthread_cond_destroy(&pipeline->wake);
+    pthread_mutex_destroy(&pipeline->lock);
+    FramePipeline_FreeBuffers(pipeline);
+    return NULL;
+  }
+
+  return pipeline;
+}
+
+void FramePipeline_Submit(FramePipeline *pipeline, const Color *keyframe, RecreationParams params) {
+  pthread_mutex_lock(&pipeline->lock);
+  int length = GetRecreationKeyframeLength(params, pipeline->width, pipeline->height);
+  memcpy(pipeline->requestKeyframe, keyframe, length * sizeof(Color));
+  pipeline->requestParams = params;
+  pipeline->requestSeq++;
+  pthread_cond_signal(&pipeline->wake);
+  pthread_mutex_unlock(&pipeline->lock);
+}
+
+// Returns the newest completed frame, or NULL if nothing was published since
+// the last call. The frame stays valid until the next acquire.
+const Color *FramePipeline_Acquire(FramePipeline *pipeline, RecreationParams *params) {
+  if ((atomic_load(&pipeline->middle) & SLOT_FRESH) == 0) {
+    return NULL;
+  }
+
+  int previous = atomic_exchange(&pipeline->middle, pipeline->front);
+  pipeline->front = previous & SLOT_INDEX_MASK;
+  if (params != NULL) {
+    *params = pipeline->frameParams[pipeline->front];
+  }
+  return pipeline->buffers[pipeline->front];
+}
+
+void FramePipeline_Exit(FramePipeline *pipeline) {
+  if (pipeline == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pipeline->lock);
+  pipeline->quit = true;
+  pthread_cond_signal(&pipeline->wake);
+  pthread_mutex_unlock(&pipeline->lock);
+  pthread_join(pipeline->thread, NULL);
+
+  pthread_cond_destroy(&pipeline->wake);
+  pthread_mutex_destroy(&pipeline->lock);
+  FramePipeline_FreeBuffers(pipeline);
+}
@@ -0,0 +1,494 @@
+#define _FILE_OFFSET_BITS 64 // Spill files can outgrow 2 GB on 32-bit long platforms
+
+#include "frame_store.h"
+#include "mem_tracker.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+typedef long long FileOffset;
+#define SeekFile _fseeki64
+#define TellFile _ftelli64
+#else
+#include <sys/types.h> // For off_t
+typedef off_t FileOffset;
+#define SeekFile fseeko
+#define TellFile ftello
+#endif
+
+#define SEGMENT_FRAMES 64
+
+// Row opcodes
+#define ROW_REF      0  // u32 index of an identical earlier row in this frame
+#define ROW_PREVIOUS 1  // Same row of the previous frame
+#define ROW_RUNS     2  // { u16 count, Color } runs covering the row
+#define ROW_DELTA    3  // { u16 skip, u16 count, count Colors } against the previous frame
+#define ROW_RAW      4  // width Colors
+#define ROW_SHIFTED  5  // u32 index of an identical row of the previous frame
+
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+} ByteBuffer;
+
+typedef struct {
+  uint8_t *data;  // NULL once spilled
+  size_t size;
+  FileOffset fileOffset;
+  int frames;
+} Segment;
+
+struct FrameStore {
+  int width;
+  int height;
+  size_t memoryHighWater;
+  size_t memoryBytes;
+  size_t diskBytes;
+  int frameCount;
+
+  Segment *segments;
+  int segmentCount;
+  int segmentCapacity;
+  ByteBuffer current;
+  int currentFrames;
+  FILE *spillFile;
+
+  // Encoder state. Row hashes and tables are kept for two frames, so rows
+  // that moved since the previous frame are found as well as repeats.
+  Color *previous;
+  bool hasPrevious;
+  uint64_t *rowHashes;
+  uint64_t *previousHashes;
+  int *rowTable;
+  int *previousTable;
+  int rowTableMask;
+  ByteBuffer runs;
+  ByteBuffer delta;
+
+  // Decoder state
+  Color *decoded[2];
+  int readSegment;
+  size_t readOffset;
+  int readFrameInSegment;
+  int readFrames;
+  ByteBuffer readBuffer;
+};
+
+//----------------------------------------------------------------------------------
+// Byte buffer helpers
+//----------------------------------------------------------------------------------
+static bool ByteBuffer_Reserve(ByteBuffer *buffer, size_t extra) {
+  if (buffer->size + extra <= buffer->capacity) return true;
+  size_t capacity = (buffer->capacity > 0) ? buffer->capacity : 4096;
+  while (capacity < buffer->size + extra) capacity *= 2;
+  uint8_t *data = TrackedRealloc(MEM_FRAMES, buffer->data, capacity);
+  if (data == NULL) return false;
+  buffer->data = data;
+  buffer->capacity = capacity;
+  return true;
+}
+
+static void ByteBuffer_Put(ByteBuffer *buffer, const void *bytes, size_t count) {
+  memcpy(buffer->data + buffer->size, bytes, count);
+  buffer->size += count;
+}
+
+static void ByteBuffer_PutU16(ByteBuffer *buffer, uint16_t value) {
+  uint8_t bytes[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+  ByteBuffer_Put(buffer, bytes, 2);
+}
+
+static uint16_t ReadU16(const uint8_t *bytes) { return (uint16_t)(bytes[0] | (bytes[1] << 8)); }
+static uint32_t ReadU32(const uint8_t *bytes) { return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24); }
+
+static bool SameColor(Color a, Color b) { return memcmp(&a, &b, sizeof(Color)) == 0; }
+
+static uint64_t HashRow(const Color *row, int width) {
+  uint64_t hash = 0x9E3779B97F4A7C15ULL;
+  const uint8_t *bytes = (const uint8_t *)row;
+  size_t size = (size_t)width * sizeof(Color);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, bytes + i, 8);
+    hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 32;
+  }
+  for (; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+  return hash;
+}
+
+//----------------------------------------------------------------------------------
+// Row encoders, each returns false if the result would not beat a raw row
+//----------------------------------------------------------------------------------
+static bool EncodeRuns(ByteBuffer *out, const Color *row, int width) {
+  size_t limit = (size_t)width * sizeof(Color);
+  out->size = 0;
+  for (int x = 0; x < width;) {
+    int run = 1;
+    while (x + run < width && run < 65535 && SameColor(row[x + run], row[x])) run++;
+    if (out->size + 6 > limit) return false;
+    ByteBuffer_PutU16(out, (uint16_t)run);
+    ByteBuffer_Put(out, &row[x], sizeof(Color));
+    x += run;
+  }
+  return true;
+}
+
+static bool EncodeDelta(ByteBuffer *out, const Color *row, const Color *reference, int width) {
+  size_t limit = (size_t)width * sizeof(Color);
+  out->size = 0;
+  for (int x = 0; x < width;) {
+    int skip = 0;
+    while (x + skip < width && skip < 65535 && SameColor(row[x + skip], reference[x + skip])) skip++;
+    int count = 0;
+    while (x + skip + count < width && count < 65535 && !SameColor(row[x + skip + count], reference[x + skip + count])) count++;
+    if (out->size + 4 + (size_t)count * sizeof(Color) > limit) return false;
+    ByteBuffer_PutU16(out, (uint16_t)skip);
+    ByteBuffer_PutU16(out, (uint16_t)count);
+    ByteBuffer_Put(out, &row[x + skip], count * sizeof(Color));
+    x += skip + count;
+  }
+  return true;
+}
+
+// Looks a row up in the previous frame's table; -1 if that frame had no such row
+static int FrameStore_FindPreviousRow(const FrameStore *store, const Color *row, uint64_t hash) {
+  size_t rowBytes = (size_t)store->width * sizeof(Color);
+  int slot = (int)(hash & store->rowTableMask);
+  while (store->previousTable[slot] >= 0) {
+    int candidate = store->previousTable[slot];
+    if (store->previousHashes[candidate] == hash &&
+        memcmp(&store->previous[(size_t)candidate * store->width], row, rowBytes) == 0) {
+      return candidate;
+    }
+    slot = (slot + 1) & store->rowTableMask;
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------------
+// Segments and spilling
+//----------------------------------------------------------------------------------
+static void FrameStore_Spill(FrameStore *store) {
+  for (int i = 0; i < store->segmentCount && store->memoryBytes > store->memoryHighWater; i++) {
+    Segment *segment = &store->segments[i];
+    if (segment->data == NULL) continue;
+    if (store->spillFile == NULL) {
+      store->spillFile = tmpfile();
+      if (store->spillFile == NULL) return;
+    }
+    if (SeekFile(store->spillFile, 0, SEEK_END) != 0) return;
+    segment->fileOffset = TellFile(store->spillFile);
+    if (segment->fileOffset < 0) return;
+    if (fwrite(segment->data, 1, segment->size, store->spillFile) != segment->size) return;
+    TrackedFree(segment->data);
+    segment->data = NULL;
+    store->diskBytes += segment->size;
+    store->memoryBytes -= segment->size;
+  }
+}
+
+static bool FrameStore_SealSegment(FrameStore *store) {
+  if (store->currentFrames == 0) return true;
+  if (store->segmentCount == store->segmentCapacity) {
+    int capacity = (store->segmentCapacity > 0) ? store->segmentCapacity * 2 : 16;
+    Segment *segments = realloc(store->segments, capacity * sizeof(Segment));
+    if (segments == NULL) return false;
+    store->segments = segments;
+    store->segmentCapacity = capacity;
+  }
+
+  Segment *segment = &store->segments[store->segmentCount++];
+  segment->data = store->current.data;
+  segment->size = store->current.size;
+  segment->fileOffset = -1;
+  segment->frames = store->currentFrames;
+
+  // The in-memory total keeps the sealed bytes, minus the unused capacity
+  uint8_t *shrunk = TrackedRealloc(MEM_FRAMES, segment->data, segment->size);
+  if (shrunk != NULL) segment->data = shrunk;
+  store->memoryBytes = store->memoryBytes - store->current.capacity + segment->size;
+  store->current = (ByteBuffer){ 0 };
+  store->currentFrames = 0;
+
+  FrameStore_Spill(store);
+  return true;
+}
+
+// Drops a partly encoded frame so the stream stays decodable. The previous
+// frame, its hashes and its row table only change once a frame is complete,
+// so they still describe the last stored frame; only the bytes written since
+// `frameStart` must go. Capacity already grown stays counted.
+static bool FrameStore_AbortFrame(FrameStore *store, size_t frameStart, size_t capacityBefore) {
+  store->current.size = frameStart;
+  store->memoryBytes += store->current.capacity - capacityBefore;
+  return false;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+FrameStore *FrameStore_Init(int width, int height, size_t memoryHighWater) {
+  FrameStore *store = calloc(1, sizeof(FrameStore));
+  if (store == NULL) {
+    return NULL;
+  }
+
+  store->width = width;
+  store->height = height;
+  store->memoryHighWater = memoryHighWater;
+  store->previous = TrackedMalloc(MEM_FRAMES, (size_t)width * height * sizeof(Color));
+  store->rowHashes = TrackedMalloc(MEM_FRAMES, height * sizeof(uint64_t));
+  store->previousHashes = TrackedMalloc(MEM_FRAMES, height * sizeof(uint64_t));
+  int tableSize = 1;
+  while (tableSize < 2 * height) tableSize *= 2;
+  store->rowTable = TrackedMalloc(MEM_FRAMES, tableSize * sizeof(int));
+  store->previousTable = TrackedMalloc(MEM_FRAMES, tableSize * sizeof(int));
+  store->rowTableMask = tableSize - 1;
+  if (store->previous == NULL || store->rowHashes == NULL || store->previousHashes == NULL ||
+      store->rowTable == NULL || store->previousTable == NULL) {
+    TrackedFree(store->previous);
+    TrackedFree(store->rowHashes);
+    TrackedFree(store->previousHashes);
+    TrackedFree(store->rowTable);
+    TrackedFree(store->previousTable);
+    free(store);
+    return NULL;
+  }
+
+  return store;
+}
+
+bool FrameStore_Append(FrameStore *store, Image frame) {
+  if (frame.width != store->width || frame.height != store->height ||
+      frame.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+    return false;
+  }
+
+  const Color *pixels = (const Color *)frame.data;
+  int width = store->width;
+  size_t rowBytes = (size_t)width * sizeof(Color);
+  size_t before = store->current.capacity;
+  size_t frameStart = store->current.size;
+  memset(store->rowTable, -1, (store->rowTableMask + 1) * sizeof(int));
+
+  for (int y = 0; y < store->height; y++) {
+    const Color *row = &pixels[(size_t)y * width];
+    const Color *previousRow = &store->previous[(size_t)y * width];
+    if (!ByteBuffer_Reserve(&store->current, 5 + rowBytes)) return FrameStore_AbortFrame(store, frameStart, before);
+
+    // Identical earlier row in this frame (alternating stripes repeat)
+    uint64_t hash = HashRow(row, width);
+    store->rowHashes[y] = hash;
+    int slot = (int)(hash & store->rowTableMask);
+    int match = -1;
+    while (store->rowTable[slot] >= 0) {
+      int candidate = store->rowTable[slot];
+      if (store->rowHashes[candidate] == hash && memcmp(&pixels[(size_t)candidate * width], row, rowBytes) == 0) {
+        match = candidate;
+        break;
+      }
+      slot = (slot + 1) & store->rowTableMask;
+    }
+    if (match >= 0) {
+      uint8_t op[5] = { ROW_REF, (uint8_t)match, (uint8_t)(match >> 8), (uint8_t)(match >> 16), (uint8_t)(match >> 24) };
+      ByteBuffer_Put(&store->current, op, 5);
+      continue;
+    }
+    store->rowTable[slot] = y;
+
+    if (store->hasPrevious && memcmp(row, previousRow, rowBytes) == 0) {
+      uint8_t op = ROW_PREVIOUS;
+      ByteBuffer_Put(&store->current, &op, 1);
+      continue;
+    }
+
+    // Identical row elsewhere in the previous frame (stripes scroll between frames)
+    if (store->hasPrevious) {
+      int shifted = FrameStore_FindPreviousRow(store, row, hash);
+      if (shifted >= 0) {
+        uint8_t op[5] = { ROW_SHIFTED, (uint8_t)shifted, (uint8_t)(shifted >> 8), (uint8_t)(shifted >> 16), (uint8_t)(shifted >> 24) };
+        ByteBuffer_Put(&store->current, op, 5);
+        continue;
+      }
+    }
+
+    // Smallest of runs, delta against the previous frame, and raw
+    if (!ByteBuffer_Reserve(&store->runs, rowBytes) || !ByteBuffer_Reserve(&store->delta, rowBytes)) {
+      return FrameStore_AbortFrame(store, frameStart, before);
+    }
+    bool haveRuns = EncodeRuns(&store->runs, row, width);
+    bool haveDelta = store->hasPrevious && EncodeDelta(&store->delta, row, previousRow, width);
+    const ByteBuffer *best = NULL;
+    uint8_t op = ROW_RAW;
+    if (haveRuns) { best = &store->runs; op = ROW_RUNS; }
+    if (haveDelta && (best == NULL || store->delta.size < best->size)) { best = &store->delta; op = ROW_DELTA; }
+
+    ByteBuffer_Put(&store->current, &op, 1);
+    if (best != NULL) ByteBuffer_Put(&store->current, best->data, best->size);
+    else ByteBuffer_Put(&store->current, row, rowBytes);
+  }
+
+  memcpy(store->previous, pixels, rowBytes * store->height);
+  store->hasPrevious = true;
+  uint64_t *hashes = store->previousHashes;
+  store->previousHashes = store->rowHashes;
+  store->rowHashes = hashes;
+  int *table = store->previousTable;
+  store->previousTable = store->rowTable;
+  store->rowTable = table;
+  store->currentFrames++;
+  store->frameCount++;
+  store->memoryBytes += store->current.capacity - before;
+
+  // The frame is stored either way; if sealing fails, it is retried next frame
+  if (store->currentFrames >= SEGMENT_FRAMES) FrameStore_SealSegment(store);
+  return true;
+}
+
+// Lowers the high-water mark and spills everything sealed above it, sealing
+// the segment being filled first. Returns false if the mark was not above it.
+bool FrameStore_SetMemoryHighWater(FrameStore *store, size_t memoryHighWater) {
+  if (memoryHighWater >= store->memoryHighWater) return false;
+  store->memoryHighWater = memoryHighWater;
+  if (!FrameStore_SealSegment(store)) return true;
+  FrameStore_Spill(store);
+  return true;
+}
+
+void FrameStore_PrintStats(const FrameStore *store) {
+  const double mb = 1024.0 * 1024.0;
+  double raw = (double)store->frameCount * store->width * store->height * sizeof(Color);
+  size_t stored = store->diskBytes + store->current.size;
+  for (int i = 0; i < store->segmentCount; i++) {
+    if (store->segments[i].data != NULL) stored += store->segments[i].size;
+  }
+  printf("Frame store: %d frames, %.1f MB raw, %.1f MB compressed (%.1fx), %.1f MB spilled to disk\n",
+         store->frameCount, raw / mb, stored / mb, (stored > 0) ? raw / stored : 0.0, store->diskBytes / mb);
+}
+
+bool FrameStore_BeginRead(FrameStore *store) {
+  if (!FrameStore_SealSegment(store)) return false;
+
+  for (int i = 0; i < 2; i++) {
+    if (store->decoded[i] == NULL) {
+      store->decoded[i] = TrackedMalloc(MEM_FRAMES, (size_t)store->width * store->height * sizeof(Color));
+      if (store->decoded[i] == NULL) return false;
+    }
+  }
+  store->readSegment = 0;
+  store->readOffset = 0;
+  store->readFrameInSegment = 0;
+  store->readFrames = 0;
+  return true;
+}
+
+// Decodes the next frame. The image is owned by the store, stays valid until
+// the next call and must not be unloaded; its data is NULL after the last frame.
+Image FrameStore_ReadNext(FrameStore *store) {
+  Image image = { NULL, store->width, store->height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+  if (store->readFrames >= store->frameCount) return image;
+
+  Segment *segment = &store->segments[store->readSegment];
+  if (store->readFrameInSegment == segment->frames) {
+    segment = &store->segments[++store->readSegment];
+    store->readOffset = 0;
+    store->readFrameInSegment = 0;
+  }
+
+  // Spilled segments are streamed back in one at a time
+  const uint8_t *data = segment->data;
+  if (data == NULL) {
+    if (store->readOffset == 0) {
+      store->readBuffer.size = 0;
+      if (!ByteBuffer_Reserve(&store->readBuffer, segment->size)) return image;
+      if (SeekFile(store->spillFile, segment->fileOffset, SEEK_SET) != 0) return image;
+      if (fread(store->readBuffer.data, 1, segment->size, store->spillFile) != segment->size) return image;
+    }
+    data = store->readBuffer.data;
+  }
+
+  int width = store->width;
+  size_t rowBytes = (size_t)width * sizeof(Color);
+  Color *frame = store->decoded[store->readFrames % 2];
+  const Color *previous = store->decoded[(store->readFrames + 1) % 2];
+  const uint8_t *cursor = data + store->readOffset;
+
+  for (int y = 0; y < store->height; y++) {
+    Color *row = &frame[(size_t)y * width];
+    uint8_t op = *cursor++;
+    switch (op) {
+      case ROW_REF:
+        memcpy(row, &frame[(size_t)ReadU32(cursor) * width], rowBytes);
+        cursor += 4;
+        break;
+      case ROW_PREVIOUS:
+        memcpy(row, &previous[(size_t)y * width], rowBytes);
+        break;
+      case ROW_SHIFTED:
+        memcpy(row, &previous[(size_t)ReadU32(cursor) * width], rowBytes);
+        cursor += 4;
+        break;
+      case ROW_RUNS:
+        for (int x = 0; x < width;) {
+          int run = ReadU16(cursor);
+          Color value;
+          memcpy(&value, cursor + 2, sizeof(Color));
+          cursor += 6;
+          for (int i = 0; i < run; i++) row[x + i] = value;
+          x += run;
+        }
+        break;
+      case ROW_DELTA:
+        for (int x = 0; x < width;) {
+          int skip = ReadU16(cursor);
+          int count = ReadU16(cursor + 2);
+          cursor += 4;
+          memcpy(&row[x], &previous[(size_t)y * width + x], skip * sizeof(Color));
+          memcpy(&row[x + skip], cursor, count * sizeof(Color));
+          cursor += count * sizeof(Color);
+          x += skip + count;
+        }
+        break;
+      default:
+        memcpy(row, cursor, rowBytes);
+        cursor += rowBytes;
+        break;
+    }
+  }
+
+  store->readOffset = (size_t)(cursor - data);
+  store->readFrameInSegment++;
+  store->readFrames++;
+  image.data = frame;
+  return image;
+}
+
+void FrameStore_Exit(FrameStore *store) {
+  if (store == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < store->segmentCount; i++) {
+    TrackedFree(store->segments[i].data);
+  }
+  free(store->segments);
+  TrackedFree(store->current.data);
+  TrackedFree(store->runs.data);
+  TrackedFree(store->delta.data);
+  TrackedFree(store->readBuffer.data);
+  if (store->spillFile != NULL) fclose(store->spillFile);
+
+  for (int i = 0; i < 2; i++) {
+    TrackedFree(store->decoded[i]);
+  }
+  TrackedFree(store->previous);
+  TrackedFree(store->rowHashes);
+  TrackedFree(store->previousHashes);
+  TrackedFree(store->rowTable);
+  TrackedFree(store->previousTable);
+  free(store);
+}
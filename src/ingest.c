@@ -0,0 +1,116 @@
+#include "ingest.h"
+#include "mem_tracker.h"
+#include <stddef.h> // For NULL
+#include <stdlib.h> // For malloc
+
+// Tile edge for the blocked transpose; a 32x32 tile of Colors (4 KB) stays in L1
+#define TRANSPOSE_BLOCK 32
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Loads an image as RGBA8 and crops away the near-black border around the content.
+// The crop rectangle in source coordinates is returned through `crop` if given.
+// Safe to call from several threads at once: LoadImage() matches the file type
+// with raylib's shared text buffers, so the file is read and decoded through
+// the memory loader instead, which only touches the caller's buffers.
+Image LoadCroppedImage(const char *filename, Rectangle *crop)
+{
+    Image image = { 0 };
+    const char *fileType = GetFileExtension(filename);
+    if (fileType == NULL) return image;
+    int dataSize = 0;
+    unsigned char *fileData = LoadFileData(filename, &dataSize);
+    if (fileData == NULL) return image;
+    image = LoadImageFromMemory(fileType, fileData, dataSize);
+    UnloadFileData(fileData);
+    if (image.data == NULL) return image;
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    Color *pixels = (Color *)image.data;
+    int left = image.width, right = 0, top = image.height, bottom = 0;
+    for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+            Color p = pixels[y * image.width + x];
+            if (p.r > 10 || p.g > 10 || p.b > 10) {
+                if (x < left)   left = x;
+                if (x > right)  right = x;
+                if (y < top)    top = y;
+                if (y > bottom) bottom = y;
+            }
+        }
+    }
+    Rectangle cropRec = { 0, 0, (float)image.width, (float)image.height };
+    if (left < right && top < bottom) {
+        cropRec = (Rectangle){ (float)left, (float)top, (float)(right - left + 1), (float)(bottom - top + 1) };
+        ImageCrop(&image, cropRec);
+    }
+    if (crop != NULL) *crop = cropRec;
+
+    return image;
+}
+
+// Returns an RGBA8 copy with rows and columns swapped, so that column x of the
+// source is the contiguous row x of the result. Built tile by tile so both the
+// reads and the writes stay within a few cache lines at a time. Free the
+// result with TrackedFree().
+Image TransposeImage(Image image)
+{
+    int width = image.width, height = image.height;
+    const Color *src = (const Color *)image.data;
+    Color *dst = (Color *)TrackedMalloc(MEM_SOURCE, (size_t)width * height * sizeof(Color));
+    if (dst == NULL) return (Image){ 0 };
+
+    for (int by = 0; by < height; by += TRANSPOSE_BLOCK) {
+        int yEnd = (by + TRANSPOSE_BLOCK < height) ? by + TRANSPOSE_BLOCK : height;
+        for (int bx = 0; bx < width; bx += TRANSPOSE_BLOCK) {
+            int xEnd = (bx + TRANSPOSE_BLOCK < width) ? bx + TRANSPOSE_BLOCK : width;
+            for (int y = by; y < yEnd; y++) {
+                for (int x = bx; x < xEnd; x++) {
+                    dst[(size_t)x * height + y] = src[(size_t)y * width + x];
+                }
+            }
+        }
+    }
+
+    return (Image){ dst, height, width, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+}
+
+// Writes the R, G and B variance of every row, summed over channels
+void ComputeRowVariance(Image image, float *variance)
+{
+    const Color *pixels = (const Color *)image.data;
+
+    for (int y = 0; y < image.height; y++) {
+        const Color *row = &pixels[y * image.width];
+        unsigned long long sum[3] = { 0 }, sumSq[3] = { 0 };
+        for (int x = 0; x < image.width; x++) {
+            sum[0] += row[x].r; sumSq[0] += row[x].r * row[x].r;
+            sum[1] += row[x].g; sumSq[1] += row[x].g * row[x].g;
+            sum[2] += row[x].b; sumSq[2] += row[x].b * row[x].b;
+        }
+
+        double total = 0.0;
+        for (int c = 0; c < 3; c++) {
+            double mean = (double)sum[c] / image.width;
+            total += (double)sumSq[c] / image.width - mean * mean;
+        }
+        variance[y] = (float)total;
+    }
+}
+
+// Returns the row whose R, G and B values vary the most, summed over channels
+int FindMaxVarianceRow(Image image)
+{
+    float *variance = (float *)malloc(image.height * sizeof(float));
+    if (variance == NULL) return 0;
+    ComputeRowVariance(image, variance);
+
+    int bestRow = 0;
+    for (int y = 1; y < image.height; y++) {
+        if (variance[y] > variance[bestRow]) bestRow = y;
+    }
+
+    free(variance);
+    return bestRow;
+}
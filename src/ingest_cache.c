@@ -0,0 +1,441 @@
+#define _FILE_OFFSET_BITS 64 // Sources and cache files can be larger than 2 GB
+
+#include "ingest_cache.h"
+#include "mem_tracker.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h> // For offsetof
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define SeekFile fseeko
+#else
+#define SeekFile _fseeki64
+#endif
+
+// Bump whenever the file layout or anything InitApp derives changes
+#define INGEST_CACHE_VERSION 2
+#define INGEST_CACHE_MAGIC   0x4548434143455228ull // "(RECACHE"
+#define SECTION_ALIGN        4096
+
+// Source fingerprint: this many blocks spread evenly over the file, including
+// its first and last, are hashed. Smaller files are hashed whole.
+#define SAMPLE_BLOCKS     16
+#define SAMPLE_BLOCK_SIZE (64 * 1024)
+#define HASH_CHUNK_SIZE   (1024 * 1024)
+
+typedef enum {
+    SECTION_ORIGINAL,
+    SECTION_CHANNEL_R,
+    SECTION_CHANNEL_G,
+    SECTION_CHANNEL_B,
+    SECTION_TRANSPOSED,
+    SECTION_DISPLAY_R,
+    SECTION_DISPLAY_G,
+    SECTION_DISPLAY_B,
+    SECTION_DISPLAY_ORIGINAL,
+    SECTION_ROW_VARIANCE,
+    SECTION_COUNT
+} CacheSection;
+
+// Sections before this are full-resolution planes, verified in the background
+#define FIRST_SMALL_SECTION SECTION_DISPLAY_R
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sourceSampleHash;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    float crop[4];
+    int32_t width;
+    int32_t height;
+    int32_t displayWidth;
+    int32_t displayHeight;
+    uint64_t fileSize;
+    uint64_t sectionOffset[SECTION_COUNT];
+    uint64_t sectionSize[SECTION_COUNT];
+    uint64_t sectionHash[SECTION_COUNT];
+    uint64_t headerHash;    // Over everything above
+} IngestCacheHeader;
+
+struct IngestCache {
+    unsigned char *base;
+    size_t size;
+    long long displayBytes;     // Part of the mapping counted under MEM_DISPLAY
+    char path[512];
+
+    // Background check of the full-resolution planes
+    pthread_t verifier;
+    bool verifierStarted;
+    atomic_bool cancel;
+};
+
+//----------------------------------------------------------------------------------
+// Module Local Functions Definition
+//----------------------------------------------------------------------------------
+static uint64_t HashBytes(uint64_t hash, const unsigned char *bytes, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    return hash;
+}
+
+static uint64_t HashHeader(const IngestCacheHeader *header)
+{
+    return HashBytes(0x9E3779B97F4A7C15ULL, (const unsigned char *)header, offsetof(IngestCacheHeader, headerHash));
+}
+
+// RECREATE_CACHE_DIR overrides the location; setting it empty disables the cache
+static const char *GetCacheDir(void)
+{
+    const char *dir = getenv("RECREATE_CACHE_DIR");
+    if (dir == NULL) return ".recreate_cache";
+    return (dir[0] != '\0') ? dir : NULL;
+}
+
+static void GetCachePath(const char *dir, const IngestCacheKey *key, char *path, size_t size)
+{
+    snprintf(path, size, "%s/%016llx.rcache", dir, (unsigned long long)key->sampleHash);
+}
+
+// Hashes every byte of the source, 1 MB at a time
+static bool HashSourceFile(IngestCacheKey *key)
+{
+    if (key->haveContentHash) return true;
+
+    FILE *file = fopen(key->path, "rb");
+    if (file == NULL) return false;
+    unsigned char *chunk = malloc(HASH_CHUNK_SIZE);
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    uint64_t total = 0;
+    size_t read = 0;
+    while (chunk != NULL && (read = fread(chunk, 1, HASH_CHUNK_SIZE, file)) > 0) {
+        hash = HashBytes(hash, chunk, read);
+        total += read;
+    }
+    bool ok = (chunk != NULL) && !ferror(file) && (total == key->size);
+    free(chunk);
+    fclose(file);
+    if (!ok) return false;
+
+    key->contentHash = hash;
+    key->haveContentHash = true;
+    return true;
+}
+
+static bool CheckSection(const unsigned char *base, const IngestCacheHeader *header, CacheSection section)
+{
+    return HashBytes(0x9E3779B97F4A7C15ULL, base + header->sectionOffset[section], header->sectionSize[section]) ==
+           header->sectionHash[section];
+}
+
+// Hashes the full-resolution planes a chunk at a time, off the startup path.
+// Their pages are read in here rather than all at once before the first frame.
+// A mismatch removes the cache file so the next launch rebuilds it.
+static void *VerifyPlanes(void *arg)
+{
+    IngestCache *cache = arg;
+    const IngestCacheHeader *header = (const IngestCacheHeader *)cache->base;
+    for (int i = 0; i < FIRST_SMALL_SECTION; i++) {
+        const unsigned char *data = cache->base + header->sectionOffset[i];
+        uint64_t size = header->sectionSize[i];
+        uint64_t hash = 0x9E3779B97F4A7C15ULL;
+        // Chunks are a multiple of 8 bytes, so chaining them matches one pass
+        for (uint64_t done = 0; done < size; done += HASH_CHUNK_SIZE) {
+            if (atomic_load(&cache->cancel)) return NULL;
+            size_t length = (size - done < HASH_CHUNK_SIZE) ? (size_t)(size - done) : HASH_CHUNK_SIZE;
+            hash = HashBytes(hash, data + done, length);
+        }
+        if (hash != header->sectionHash[i]) {
+            printf("Ingest cache %s is corrupt, it will be rebuilt on the next launch\n", cache->path);
+            remove(cache->path);
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+// Records a new source modification time once the full content hash has
+// confirmed the source is unchanged, so later launches skip that hash
+static void UpdateSourceMtime(const char *path, const IngestCacheHeader *mapped, int64_t mtime)
+{
+    IngestCacheHeader header = *mapped;
+    header.sourceMtime = mtime;
+    header.headerHash = HashHeader(&header);
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL) return;
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+}
+
+static const void *SectionData(const IngestResult *result, CacheSection section)
+{
+    switch (section) {
+        case SECTION_ORIGINAL: return result->original.data;
+        case SECTION_CHANNEL_R: return result->channels[0].data;
+        case SECTION_CHANNEL_G: return result->channels[1].data;
+        case SECTION_CHANNEL_B: return result->channels[2].data;
+        case SECTION_TRANSPOSED: return result->transposed.data;
+        case SECTION_DISPLAY_R: return result->display[0].data;
+        case SECTION_DISPLAY_G: return result->display[1].data;
+        case SECTION_DISPLAY_B: return result->display[2].data;
+        case SECTION_DISPLAY_ORIGINAL: return result->display[3].data;
+        case SECTION_ROW_VARIANCE: return result->rowVariance;
+        default: return NULL;
+    }
+}
+
+static Image MappedImage(unsigned char *base, const IngestCacheHeader *header, CacheSection section, int width, int height)
+{
+    return (Image){ base + header->sectionOffset[section], width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+}
+
+#ifndef _WIN32
+#define MAPPING_CATEGORY MEM_MAPPED
+#else
+#define MAPPING_CATEGORY MEM_SOURCE // A heap copy, unlike a mapping
+#endif
+
+static unsigned char *MapFile(const char *path, size_t *size)
+{
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(IngestCacheHeader)) {
+        close(fd);
+        return NULL;
+    }
+    // Read-only mapping: pages are only read in when touched, and a stray
+    // write faults instead of silently copying the page
+    void *base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+    *size = (size_t)info.st_size;
+    TrackBytes(MAPPING_CATEGORY, (long long)*size);
+    return base;
+#else
+    int bytes = 0;
+    unsigned char *data = LoadFileData(path, &bytes);
+    if (data == NULL || bytes < (int)sizeof(IngestCacheHeader)) {
+        UnloadFileData(data);
+        return NULL;
+    }
+    *size = (size_t)bytes;
+    TrackBytes(MAPPING_CATEGORY, bytes);
+    return data;
+#endif
+}
+
+static void UnmapFile(unsigned char *base, size_t size)
+{
+    TrackBytes(MAPPING_CATEGORY, -(long long)size);
+#ifndef _WIN32
+    munmap(base, size);
+#else
+    UnloadFileData(base);
+#endif
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Fingerprints the source from its size, modification time and a few sampled
+// blocks, so a cache hit costs about 1 MB of reads however large the scan is
+bool IngestCache_ComputeKey(const char *sourcePath, IngestCacheKey *key)
+{
+    memset(key, 0, sizeof(*key));
+    snprintf(key->path, sizeof(key->path), "%s", sourcePath);
+#ifdef _WIN32
+    struct __stat64 info;
+    if (_stat64(sourcePath, &info) != 0) return false;
+#else
+    struct stat info;
+    if (stat(sourcePath, &info) != 0) return false;
+#endif
+    key->size = (uint64_t)info.st_size;
+    key->mtime = (int64_t)info.st_mtime;
+
+    FILE *file = fopen(sourcePath, "rb");
+    if (file == NULL) return false;
+    unsigned char *block = malloc(SAMPLE_BLOCK_SIZE);
+    uint64_t hash = HashBytes(0xCBF29CE484222325ULL, (const unsigned char *)&key->size, sizeof(key->size));
+    bool ok = (block != NULL);
+    uint64_t sampled = (uint64_t)SAMPLE_BLOCKS * SAMPLE_BLOCK_SIZE;
+    int blocks = (key->size <= sampled) ? (int)((key->size + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE) : SAMPLE_BLOCKS;
+    for (int i = 0; ok && i < blocks; i++) {
+        uint64_t offset = (key->size <= sampled) ? (uint64_t)i * SAMPLE_BLOCK_SIZE
+                        : (key->size - SAMPLE_BLOCK_SIZE) * i / (SAMPLE_BLOCKS - 1);
+        size_t length = (key->size - offset < SAMPLE_BLOCK_SIZE) ? (size_t)(key->size - offset) : SAMPLE_BLOCK_SIZE;
+        ok = SeekFile(file, offset, SEEK_SET) == 0 && fread(block, 1, length, file) == length;
+        if (ok) hash = HashBytes(hash, block, length);
+    }
+    free(block);
+    fclose(file);
+    if (!ok) return false;
+
+    key->sampleHash = hash;
+    return true;
+}
+
+// Maps the cache file for `key` and fills `result` with images pointing into
+// it. Returns NULL if there is no cache, it is stale, or its header or small
+// sections are corrupt. The full-resolution planes are verified in the
+// background, so load time does not grow with the scan.
+IngestCache *IngestCache_Load(IngestCacheKey *key, IngestResult *result)
+{
+    const char *dir = GetCacheDir();
+    if (dir == NULL) return NULL;
+    char path[512];
+    GetCachePath(dir, key, path, sizeof(path));
+
+    size_t size = 0;
+    unsigned char *base = MapFile(path, &size);
+    if (base == NULL) return NULL;
+
+    const IngestCacheHeader *header = (const IngestCacheHeader *)base;
+    bool valid = header->magic == INGEST_CACHE_MAGIC && header->version == INGEST_CACHE_VERSION &&
+                 header->headerSize == sizeof(IngestCacheHeader) && header->headerHash == HashHeader(header) &&
+                 header->sourceSampleHash == key->sampleHash && header->sourceSize == key->size && header->fileSize == size;
+    for (int i = 0; valid && i < SECTION_COUNT; i++) {
+        valid = header->sectionOffset[i] + header->sectionSize[i] <= size;
+    }
+    if (valid && header->sourceMtime != key->mtime) {
+        // Touched or copied since the cache was written; the fingerprint alone
+        // cannot tell whether unsampled bytes changed, so compare everything
+        valid = HashSourceFile(key) && header->sourceHash == key->contentHash;
+        if (valid) UpdateSourceMtime(path, header, key->mtime);
+    }
+    // Only the small sections are checked up front; the planes follow below
+    for (int i = FIRST_SMALL_SECTION; valid && i < SECTION_COUNT; i++) {
+        valid = CheckSection(base, header, i);
+    }
+    if (!valid) {
+        printf("Ingest cache %s is stale or corrupt, rebuilding\n", path);
+        UnmapFile(base, size);
+        return NULL;
+    }
+
+    int width = header->width, height = header->height;
+    int displayWidth = header->displayWidth, displayHeight = header->displayHeight;
+    result->crop = (Rectangle){ header->crop[0], header->crop[1], header->crop[2], header->crop[3] };
+    result->original = MappedImage(base, header, SECTION_ORIGINAL, width, height);
+    result->channels[0] = MappedImage(base, header, SECTION_CHANNEL_R, width, height);
+    result->channels[1] = MappedImage(base, header, SECTION_CHANNEL_G, width, height);
+    result->channels[2] = MappedImage(base, header, SECTION_CHANNEL_B, width, height);
+    result->transposed = MappedImage(base, header, SECTION_TRANSPOSED, height, width);
+    for (int i = 0; i < 4; i++) {
+        result->display[i] = MappedImage(base, header, SECTION_DISPLAY_R + i, displayWidth, displayHeight);
+    }
+    result->rowVariance = (float *)(base + header->sectionOffset[SECTION_ROW_VARIANCE]);
+
+    IngestCache *cache = calloc(1, sizeof(IngestCache));
+    if (cache == NULL) {
+        UnmapFile(base, size);
+        return NULL;
+    }
+    cache->base = base;
+    cache->size = size;
+    snprintf(cache->path, sizeof(cache->path), "%s", path);
+    atomic_init(&cache->cancel, false);
+    cache->verifierStarted = (pthread_create(&cache->verifier, NULL, VerifyPlanes, cache) == 0);
+    if (!cache->verifierStarted) VerifyPlanes(cache);
+
+    // The display planes stand in for the display images a miss builds, so
+    // they are counted the same way
+    cache->displayBytes = 0;
+    for (int i = SECTION_DISPLAY_R; i <= SECTION_DISPLAY_ORIGINAL; i++) cache->displayBytes += (long long)header->sectionSize[i];
+    TrackBytes(MAPPING_CATEGORY, -cache->displayBytes);
+    TrackBytes(MEM_DISPLAY, cache->displayBytes);
+    return cache;
+}
+
+// Writes the cache to a temp file and renames it into place, so a crash
+// mid-write never leaves a truncated cache behind under the final name
+bool IngestCache_Save(IngestCacheKey *key, const IngestResult *result)
+{
+    const char *dir = GetCacheDir();
+    if (dir == NULL) return false;
+    if (!HashSourceFile(key)) return false;
+    MakeDirectory(dir);
+
+    int width = result->original.width, height = result->original.height;
+    size_t planeBytes = (size_t)width * height * sizeof(Color);
+    size_t displayBytes = (size_t)result->display[0].width * result->display[0].height * sizeof(Color);
+
+    IngestCacheHeader header = { 0 };
+    header.magic = INGEST_CACHE_MAGIC;
+    header.version = INGEST_CACHE_VERSION;
+    header.headerSize = sizeof(IngestCacheHeader);
+    header.sourceSampleHash = key->sampleHash;
+    header.sourceHash = key->contentHash;
+    header.sourceSize = key->size;
+    header.sourceMtime = key->mtime;
+    header.crop[0] = result->crop.x; header.crop[1] = result->crop.y;
+    header.crop[2] = result->crop.width; header.crop[3] = result->crop.height;
+    header.width = width;
+    header.height = height;
+    header.displayWidth = result->display[0].width;
+    header.displayHeight = result->display[0].height;
+
+    uint64_t offset = SECTION_ALIGN;
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        if (i <= SECTION_TRANSPOSED) header.sectionSize[i] = planeBytes;
+        else if (i < SECTION_ROW_VARIANCE) header.sectionSize[i] = displayBytes;
+        else header.sectionSize[i] = (uint64_t)height * sizeof(float);
+        header.sectionOffset[i] = offset;
+        offset = (offset + header.sectionSize[i] + SECTION_ALIGN - 1) & ~(uint64_t)(SECTION_ALIGN - 1);
+        header.sectionHash[i] = HashBytes(0x9E3779B97F4A7C15ULL, SectionData(result, i), header.sectionSize[i]);
+    }
+    header.fileSize = header.sectionOffset[SECTION_COUNT - 1] + header.sectionSize[SECTION_COUNT - 1];
+    header.headerHash = HashHeader(&header);
+
+    char path[512], tempPath[520];
+    GetCachePath(dir, key, path, sizeof(path));
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FILE *file = fopen(tempPath, "wb");
+    if (file == NULL) return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int i = 0; ok && i < SECTION_COUNT; i++) {
+        ok = SeekFile(file, header.sectionOffset[i], SEEK_SET) == 0 &&
+             fwrite(SectionData(result, i), 1, header.sectionSize[i], file) == header.sectionSize[i];
+    }
+    ok = (fclose(file) == 0) && ok;
+
+#ifdef _WIN32
+    remove(path); // rename() does not replace existing files on Windows
+#endif
+    if (!ok || rename(tempPath, path) != 0) {
+        remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+void IngestCache_Close(IngestCache *cache)
+{
+    if (cache == NULL) return;
+    atomic_store(&cache->cancel, true);
+    if (cache->verifierStarted) pthread_join(cache->verifier, NULL);
+    TrackBytes(MEM_DISPLAY, -cache->displayBytes);
+    TrackBytes(MAPPING_CATEGORY, cache->displayBytes);
+    UnmapFile(cache->base, cache->size);
+    free(cache);
+}
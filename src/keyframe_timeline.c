@@ -0,0 +1,211 @@
+#include "keyframe_timeline.h"
+#include "mem_tracker.h"
+#include <math.h> // For fmodf
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Sixteen 16-bit lanes, four RGBA pixels; lowered to SSE/AVX/NEON as available
+#define LANES 16
+typedef uint8_t ByteVector __attribute__((vector_size(LANES)));
+typedef uint16_t BlendVector __attribute__((vector_size(LANES * sizeof(uint16_t))));
+typedef int16_t WeightVector __attribute__((vector_size(LANES * sizeof(int16_t))));
+
+// Blend weights are 8.8 fixed point, 0 = previous keyframe, 256 = next
+#define WEIGHT_ONE 256
+// Width of the sweep's soft edge as a fraction of the line, in 1/256ths
+#define SWEEP_EDGE_SHIFT 2
+#define SWEEP_EDGE (WEIGHT_ONE >> SWEEP_EDGE_SHIFT)
+
+struct KeyframeTimeline {
+  int capacity;           // Pixels per keyframe slot
+  int length;             // Pixels actually used by the captured lines
+  bool vertical;
+  float loopSpacing;      // Animation time from the last keyframe back to the first
+  KeyframeBlendMode mode;
+
+  int count;
+  int allocated;
+  Color *lines;           // allocated * capacity pixels
+  float *times;           // Start time of each keyframe
+
+  uint16_t easeTable[WEIGHT_ONE + 1];  // Smoothstep over linear progress
+  int16_t *sweepRamp;     // Per byte: position of its pixel along the line, 0..255
+};
+
+// Rebuilt only when the line length changes, never per frame
+static void KeyframeTimeline_BuildSweepRamp(KeyframeTimeline *timeline) {
+  for (int x = 0; x < timeline->length; x++) {
+    int16_t position = (int16_t)((x * WEIGHT_ONE) / timeline->length);
+    for (int c = 0; c < 4; c++) timeline->sweepRamp[4 * x + c] = position;
+  }
+}
+
+// out = (a * (256 - w) + b * w) >> 8 on every byte; the sum always fits in 16 bits
+static void KeyframeTimeline_Crossfade(const uint8_t *a, const uint8_t *b, int bytes, uint16_t weight, uint8_t *out) {
+  int i = 0;
+  BlendVector wb = (BlendVector){ 0 } + weight;
+  BlendVector wa = (BlendVector){ 0 } + (uint16_t)(WEIGHT_ONE - weight);
+  for (; i + LANES <= bytes; i += LANES) {
+    ByteVector va, vb;
+    memcpy(&va, a + i, LANES);
+    memcpy(&vb, b + i, LANES);
+    BlendVector mixed = (__builtin_convertvector(va, BlendVector) * wa + __builtin_convertvector(vb, BlendVector) * wb) >> 8;
+    ByteVector result = __builtin_convertvector(mixed, ByteVector);
+    memcpy(out + i, &result, LANES);
+  }
+  for (; i < bytes; i++) out[i] = (uint8_t)((a[i] * (WEIGHT_ONE - weight) + b[i] * weight) >> 8);
+}
+
+// Each pixel switches over once the sweep front passes its position in the ramp
+static void KeyframeTimeline_Sweep(const uint8_t *a, const uint8_t *b, const int16_t *ramp, int bytes, int progress, uint8_t *out) {
+  int16_t front = (int16_t)(progress * (WEIGHT_ONE + SWEEP_EDGE) / WEIGHT_ONE);
+  int i = 0;
+  WeightVector vfront = (WeightVector){ 0 } + front;
+  WeightVector one = (WeightVector){ 0 } + WEIGHT_ONE;
+  for (; i + LANES <= bytes; i += LANES) {
+    ByteVector va, vb;
+    WeightVector vramp;
+    memcpy(&va, a + i, LANES);
+    memcpy(&vb, b + i, LANES);
+    memcpy(&vramp, ramp + i, sizeof(vramp));
+
+    // Clamp (front - ramp) * 4 to 0..256 with lane masks
+    WeightVector w = (vfront - vramp) * (1 << SWEEP_EDGE_SHIFT);
+    w &= (w > 0);
+    WeightVector over = (w > one);
+    w = (w & ~over) | (one & over);
+
+    BlendVector wb = (BlendVector)w;
+    BlendVector wa = (BlendVector)(one - w);
+    BlendVector mixed = (__builtin_convertvector(va, BlendVector) * wa + __builtin_convertvector(vb, BlendVector) * wb) >> 8;
+    ByteVector result = __builtin_convertvector(mixed, ByteVector);
+    memcpy(out + i, &result, LANES);
+  }
+  for (; i < bytes; i++) {
+    int w = (front - ramp[i]) * (1 << SWEEP_EDGE_SHIFT);
+    w = (w < 0) ? 0 : (w > WEIGHT_ONE) ? WEIGHT_ONE : w;
+    out[i] = (uint8_t)((a[i] * (WEIGHT_ONE - w) + b[i] * w) >> 8);
+  }
+}
+
+KeyframeTimeline *KeyframeTimeline_Init(int capacity, float loopSpacing) {
+  KeyframeTimeline *timeline = calloc(1, sizeof(KeyframeTimeline));
+  if (timeline == NULL) {
+    return NULL;
+  }
+  timeline->capacity = capacity;
+  timeline->loopSpacing = (loopSpacing > 0.0f) ? loopSpacing : 1.0f;
+  timeline->mode = KEYFRAME_BLEND_CROSSFADE;
+  timeline->sweepRamp = TrackedMalloc(MEM_RECREATION, (size_t)capacity * 4 * sizeof(int16_t));
+  if (timeline->sweepRamp == NULL) {
+    free(timeline);
+    return NULL;
+  }
+  for (int i = 0; i <= WEIGHT_ONE; i++) {
+    float x = (float)i / WEIGHT_ONE;
+    timeline->easeTable[i] = (uint16_t)(x * x * (3.0f - 2.0f * x) * WEIGHT_ONE + 0.5f);
+  }
+  return timeline;
+}
+
+// Whether a line can join the timeline; lines on the other axis or of another
+// length cannot be blended with the ones already captured
+bool KeyframeTimeline_Matches(const KeyframeTimeline *timeline, int length, bool vertical) {
+  return timeline->count == 0 || (vertical == timeline->vertical && length == timeline->length);
+}
+
+// Adds a keyframe at animation time `time`. Times must increase; one at or
+// before the last keyframe is placed one unit after it. Returns false, and
+// leaves the timeline unchanged, if the line does not match.
+bool KeyframeTimeline_Append(KeyframeTimeline *timeline, const Color *scanline, int length, bool vertical, float time) {
+  if (!KeyframeTimeline_Matches(timeline, length, vertical) || length > timeline->capacity) {
+    return false;
+  }
+  if (timeline->count == timeline->allocated) {
+    int allocated = (timeline->allocated > 0) ? timeline->allocated * 2 : 4;
+    Color *lines = TrackedRealloc(MEM_RECREATION, timeline->lines, (size_t)allocated * timeline->capacity * sizeof(Color));
+    if (lines == NULL) return false;
+    timeline->lines = lines;
+    float *times = TrackedRealloc(MEM_RECREATION, timeline->times, allocated * sizeof(float));
+    if (times == NULL) return false;
+    timeline->times = times;
+    timeline->allocated = allocated;
+  }
+  if (timeline->count == 0) {
+    timeline->length = length;
+    timeline->vertical = vertical;
+    KeyframeTimeline_BuildSweepRamp(timeline);
+  }
+
+  memcpy(&timeline->lines[(size_t)timeline->count * timeline->capacity], scanline, length * sizeof(Color));
+  if (timeline->count == 0) {
+    time = 0.0f;
+  } else if (time <= timeline->times[timeline->count - 1]) {
+    time = timeline->times[timeline->count - 1] + 1.0f;
+  }
+  timeline->times[timeline->count] = time;
+  timeline->count++;
+  return true;
+}
+
+void KeyframeTimeline_Clear(KeyframeTimeline *timeline) {
+  timeline->count = 0;
+}
+
+int KeyframeTimeline_Count(const KeyframeTimeline *timeline) {
+  return timeline->count;
+}
+
+void KeyframeTimeline_SetBlendMode(KeyframeTimeline *timeline, KeyframeBlendMode mode) {
+  timeline->mode = mode;
+}
+
+KeyframeBlendMode KeyframeTimeline_GetBlendMode(const KeyframeTimeline *timeline) {
+  return timeline->mode;
+}
+
+// Writes the blended keyframe line for animation time t. The timeline loops,
+// with the last keyframe blending back into the first over loopSpacing.
+void KeyframeTimeline_Sample(KeyframeTimeline *timeline, float t, Color *out) {
+  if (timeline->count == 0) return;
+  const uint8_t *lines = (const uint8_t *)timeline->lines;
+  size_t stride = (size_t)timeline->capacity * sizeof(Color);
+  int bytes = timeline->length * (int)sizeof(Color);
+  if (timeline->count == 1) {
+    memcpy(out, lines, bytes);
+    return;
+  }
+
+  float period = timeline->times[timeline->count - 1] + timeline->loopSpacing;
+  float local = fmodf(t, period);
+  if (local < 0.0f) local += period;
+
+  // Last keyframe starting at or before local
+  int low = 0, high = timeline->count - 1;
+  while (low < high) {
+    int mid = (low + high + 1) / 2;
+    if (timeline->times[mid] <= local) low = mid;
+    else high = mid - 1;
+  }
+  int next = (low + 1) % timeline->count;
+  float end = (next > 0) ? timeline->times[next] : period;
+  int progress = (int)((local - timeline->times[low]) / (end - timeline->times[low]) * WEIGHT_ONE);
+  progress = (progress < 0) ? 0 : (progress > WEIGHT_ONE) ? WEIGHT_ONE : progress;
+
+  const uint8_t *a = lines + low * stride;
+  const uint8_t *b = lines + next * stride;
+  if (timeline->mode == KEYFRAME_BLEND_SWEEP) {
+    KeyframeTimeline_Sweep(a, b, timeline->sweepRamp, bytes, progress, (uint8_t *)out);
+  } else {
+    KeyframeTimeline_Crossfade(a, b, bytes, timeline->easeTable[progress], (uint8_t *)out);
+  }
+}
+
+void KeyframeTimeline_Exit(KeyframeTimeline *timeline) {
+  if (timeline == NULL) return;
+  TrackedFree(timeline->lines);
+  TrackedFree(timeline->times);
+  TrackedFree(timeline->sweepRamp);
+  free(timeline);
+}
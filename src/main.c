@@ -1,20 +1,42 @@
 #include "raylib.h"
 #include "app.h"
+#include "batch.h"
 #include <stdio.h>
+#include <string.h>
+
+static void PrintUsage(const char *program)
+{
+    printf("Usage: %s <image_file> [--shm <name>]\n", program);
+    printf("       %s --batch <directory|glob> [options]\n", program);
+}
 
 int main(int argc, char *argv[])
 {
     if (argc < 2) {
-        printf("Usage: %s <image_file>\n", argv[0]);
+        PrintUsage(argv[0]);
         return 1;
     }
 
+    // Headless batch mode, no window
+    if (strcmp(argv[1], "--batch") == 0) {
+        return RunBatch(argc - 2, argv + 2);
+    }
+
+    // Parse options before opening a window so bad arguments fail fast
+    AppState state = { 0 };
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) state.shmName = argv[++i];
+        else {
+            printf("Unknown option: %s\n", argv[i]);
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
     const int screenWidth = 1400;
     const int screenHeight = 800;
     InitWindow(screenWidth, screenHeight, "Image Tool");
     SetTargetFPS(60);
-
-    AppState state = { 0 };
     InitApp(&state, argv[1]);
     RunApp(&state);
     CleanupApp(&state);
@@ -0,0 +1,161 @@
+#include "mem_tracker.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition
+//----------------------------------------------------------------------------------
+static const char *categoryNames[MEM_CATEGORY_COUNT] = {
+    "Source", "Channels", "Display", "Recreation", "Pipeline", "GPU", "Frames", "Shared", "Mapped"
+};
+
+// Prepended to every tracked allocation; the union keeps the user block aligned
+// like plain malloc, which the vectorized blend loops rely on
+typedef union {
+    struct {
+        size_t size;
+        MemCategory category;
+    } info;
+    max_align_t align;
+} AllocHeader;
+
+static atomic_llong liveBytes[MEM_CATEGORY_COUNT];
+static atomic_llong peakBytes[MEM_CATEGORY_COUNT];
+static atomic_llong liveTotal;
+static atomic_llong peakTotal;
+static size_t memoryBudget = 0; // 0 means unlimited
+
+//----------------------------------------------------------------------------------
+// Module Local Functions Definition
+//----------------------------------------------------------------------------------
+static void RaisePeak(atomic_llong *peak, long long value)
+{
+    long long current = atomic_load(peak);
+    while (value > current && !atomic_compare_exchange_weak(peak, &current, value)) { }
+}
+
+static long long ImageBytes(Image image)
+{
+    if (image.data == NULL) return 0;
+    return GetPixelDataSize(image.width, image.height, image.format);
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+void TrackBytes(MemCategory category, long long bytes)
+{
+    long long live = atomic_fetch_add(&liveBytes[category], bytes) + bytes;
+    RaisePeak(&peakBytes[category], live);
+    if (category == MEM_MAPPED) return; // Clean pages are dropped under pressure, not swapped
+
+    long long total = atomic_fetch_add(&liveTotal, bytes) + bytes;
+    RaisePeak(&peakTotal, total);
+}
+
+void *TrackedMalloc(MemCategory category, size_t size)
+{
+    AllocHeader *header = (AllocHeader *)malloc(sizeof(AllocHeader) + size);
+    if (header == NULL) return NULL;
+
+    header->info.size = size;
+    header->info.category = category;
+    TrackBytes(category, (long long)size);
+    return header + 1;
+}
+
+void *TrackedCalloc(MemCategory category, size_t count, size_t size)
+{
+    if (size != 0 && count > ((size_t)-1 - sizeof(AllocHeader)) / size) return NULL;
+
+    AllocHeader *header = (AllocHeader *)calloc(1, sizeof(AllocHeader) + count * size);
+    if (header == NULL) return NULL;
+
+    header->info.size = count * size;
+    header->info.category = category;
+    TrackBytes(category, (long long)(count * size));
+    return header + 1;
+}
+
+// Like realloc: on failure the old block is left untouched and NULL is returned.
+// `category` is only used when `ptr` is NULL; an existing block keeps its own.
+void *TrackedRealloc(MemCategory category, void *ptr, size_t size)
+{
+    if (ptr == NULL) return TrackedMalloc(category, size);
+
+    AllocHeader *header = (AllocHeader *)ptr - 1;
+    size_t oldSize = header->info.size;
+    AllocHeader *resized = (AllocHeader *)realloc(header, sizeof(AllocHeader) + size);
+    if (resized == NULL) return NULL;
+
+    resized->info.size = size;
+    TrackBytes(resized->info.category, (long long)size - (long long)oldSize);
+    return resized + 1;
+}
+
+void TrackedFree(void *ptr)
+{
+    if (ptr == NULL) return;
+
+    AllocHeader *header = (AllocHeader *)ptr - 1;
+    TrackBytes(header->info.category, -(long long)header->info.size);
+    free(header);
+}
+
+void TrackImage(MemCategory category, Image image) { TrackBytes(category, ImageBytes(image)); }
+void UntrackImage(MemCategory category, Image image) { TrackBytes(category, -ImageBytes(image)); }
+
+// GPU memory is not visible to us, so textures are estimated as tightly packed RGBA8
+void TrackTexture(Texture2D texture) { if (texture.id > 0) TrackBytes(MEM_GPU, (long long)texture.width * texture.height * 4); }
+void UntrackTexture(Texture2D texture) { if (texture.id > 0) TrackBytes(MEM_GPU, -(long long)texture.width * texture.height * 4); }
+
+void SetMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+size_t GetMemoryBudget(void) { return memoryBudget; }
+
+// Checks whether `bytes` more can be allocated without going over the budget
+bool MemoryBudgetAllows(size_t bytes)
+{
+    if (memoryBudget == 0) return true;
+    return GetTrackedTotal() + bytes <= memoryBudget;
+}
+
+size_t GetTrackedBytes(MemCategory category)
+{
+    long long live = atomic_load(&liveBytes[category]);
+    return (live > 0) ? (size_t)live : 0;
+}
+
+size_t GetTrackedTotal(void)
+{
+    long long live = atomic_load(&liveTotal);
+    return (live > 0) ? (size_t)live : 0;
+}
+
+void DrawMemoryOverlay(int posX, int posY)
+{
+    const float mb = 1024.0f * 1024.0f;
+    int lineHeight = 14;
+
+    DrawRectangle(posX - 5, posY - 5, 200, (MEM_CATEGORY_COUNT + 2) * lineHeight + 10, (Color){ 0, 0, 0, 180 });
+    for (int i = 0; i < MEM_CATEGORY_COUNT; i++) {
+        DrawText(TextFormat("%-10s %8.1f MB", categoryNames[i], GetTrackedBytes(i) / mb), posX, posY + i * lineHeight, 10, LIGHTGRAY);
+    }
+
+    int totalY = posY + MEM_CATEGORY_COUNT * lineHeight;
+    bool nearBudget = (memoryBudget > 0) && (GetTrackedTotal() > memoryBudget * 0.9);
+    DrawText(TextFormat("Total      %8.1f MB", GetTrackedTotal() / mb), posX, totalY, 10, nearBudget ? RED : WHITE);
+    if (memoryBudget > 0) DrawText(TextFormat("Budget     %8.1f MB", memoryBudget / mb), posX, totalY + lineHeight, 10, GRAY);
+    else DrawText("Budget     unlimited", posX, totalY + lineHeight, 10, GRAY);
+}
+
+void ReportMemoryUsage(void)
+{
+    const double mb = 1024.0 * 1024.0;
+
+    printf("Peak memory usage by category:\n");
+    for (int i = 0; i < MEM_CATEGORY_COUNT; i++) {
+        printf("  %-10s %10.1f MB\n", categoryNames[i], atomic_load(&peakBytes[i]) / mb);
+    }
+    printf("  %-10s %10.1f MB\n", "Total", atomic_load(&peakTotal) / mb);
+}
@@ -1,5 +1,6 @@
 #include "recreate_view_shader.h"
 #include "globals.h"
+#include "mem_tracker.h"
 #include "raylib.h"
 #include <stdlib.h>
 
@@ -14,6 +15,7 @@ RecreateShaderView *RecreateShaderView_Init(AppState *state) {
   }
 
   view->texture = LoadTexture("assets/TARGET5.png");   // Load model texture (diffuse map)
+  TrackTexture(view->texture);
   
 
   view->shader = LoadShader(0, "src/recreate_view_shader.fs");
@@ -23,6 +25,7 @@ RecreateShaderView *RecreateShaderView_Init(AppState *state) {
   SetShaderValue(view->shader, view->swirlCenterLoc, view->swirlCenter, SHADER_UNIFORM_VEC2);
   // Create a RenderTexture2D to be used for render to texture
   view->target = LoadRenderTexture(view->texture.width, view->texture.height);
+  TrackTexture(view->target.texture);
 
   // Get shader uniform locations
   view->timeLoc = GetShaderLocation(view->shader, "u_time");
@@ -51,8 +54,6 @@ void RecreateShaderView_Update(RecreateShaderView *view, AppState *state) {
 }
 
 void RecreateShaderView_Draw(RecreateShaderView *view, AppState *state) {
-  (void)state; // Unused
-
   Vector2 mousePosition = GetMousePosition();
   view->swirlCenter[0] = mousePosition.x;
   view->swirlCenter[1] = GetScreenHeight() - mousePosition.y;
@@ -75,6 +76,7 @@ void RecreateShaderView_Draw(RecreateShaderView *view, AppState *state) {
   EndShaderMode();
 
   // DrawFPS(10, 10);
+  if (state->showMemoryOverlay) DrawMemoryOverlay(790, 10);
   EndDrawing();
 
   // After the first frame is drawn, capture screenshot and exit
@@ -86,6 +88,10 @@ void RecreateShaderView_Draw(RecreateShaderView *view, AppState *state) {
 }
 
 void RecreateShaderView_Exit(RecreateShaderView *view) {
+  UntrackTexture(view->target.texture);
+  UnloadRenderTexture(view->target);
+  UntrackTexture(view->texture);
+  UnloadTexture(view->texture);
   UnloadShader(view->shader);
   free(view);
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "recreation.h"
+#include <string.h> // For memcpy
+
+//----------------------------------------------------------------------------------
+// Module Local Functions Definition
+//----------------------------------------------------------------------------------
+static int MapSource(RecreationRowMap map, int length, int pos)
+{
+    return (((map.start + map.direction * pos) % length) + length) % length;
+}
+
+// Vertical stripes: each output row only ever shows two keyframe values, one
+// for forward stripes and one for reversed stripes, so rows are filled as runs.
+static void GenerateVerticalFrame(const Color *keyframe, int width, int height, RecreationParams params, Color *out)
+{
+    RecreationRowMap forward = GetRecreationRowMap(params, height, 0);
+    RecreationRowMap reverse = GetRecreationRowMap(params, height, params.stripe_height);
+
+    for (int y = 0; y < height; y++) {
+        Color values[2] = { keyframe[MapSource(forward, height, y)], keyframe[MapSource(reverse, height, y)] };
+        if (params.animating) { values[0].a = 255; values[1].a = 255; }
+
+        Color *row = &out[y * width];
+        for (int x = 0; x < width; x += params.stripe_height) {
+            Color value = values[(x / params.stripe_height) % 2];
+            int end = (x + params.stripe_height < width) ? x + params.stripe_height : width;
+            for (int i = x; i < end; i++) row[i] = value;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+int GetRecreationKeyframeLength(RecreationParams params, int width, int height)
+{
+    return params.vertical ? height : width;
+}
+
+RecreationRowMap GetRecreationRowMap(RecreationParams params, int length, int stripePos)
+{
+    bool reversed = ((stripePos / params.stripe_height) % 2 != 0);
+    RecreationRowMap map = { 0, 1 };
+
+    if (params.animating) {
+        map.start = params.z_offset + (reversed ? -(int)params.t : (int)params.t);
+    } else if (reversed) {
+        map.start = (length - 1) + params.z_offset;
+        map.direction = -1;
+    }
+    map.start = ((map.start % length) + length) % length;
+
+    return map;
+}
+
+// Fills one keyframe index per pixel of output row y
+void GetRecreationRowIndices(RecreationParams params, int width, int height, int y, int *indices)
+{
+    if (params.vertical) {
+        int forward = MapSource(GetRecreationRowMap(params, height, 0), height, y);
+        int reverse = MapSource(GetRecreationRowMap(params, height, params.stripe_height), height, y);
+        for (int x = 0; x < width; x++) {
+            indices[x] = ((x / params.stripe_height) % 2 != 0) ? reverse : forward;
+        }
+        return;
+    }
+
+    RecreationRowMap map = GetRecreationRowMap(params, width, y);
+    int sourceX = map.start;
+    for (int x = 0; x < width; x++) {
+        indices[x] = sourceX;
+        sourceX += map.direction;
+        if (sourceX == width) sourceX = 0;
+        else if (sourceX < 0) sourceX = width - 1;
+    }
+}
+
+// Fills a width x height frame with alternating stripes of the keyframe line.
+// Every row of a horizontal stripe uses the same source mapping, so only the
+// first row of each stripe is gathered and the rest are copied from it.
+void GenerateRecreationFrame(const Color *keyframe, int width, int height, RecreationParams params, Color *out)
+{
+    if (params.vertical) {
+        GenerateVerticalFrame(keyframe, width, height, params, out);
+        return;
+    }
+
+    for (int y = 0; y < height; y++) {
+        Color *row = &out[y * width];
+
+        if ((y % params.stripe_height) != 0) {
+            memcpy(row, row - width, width * sizeof(Color));
+            continue;
+        }
+
+        RecreationRowMap map = GetRecreationRowMap(params, width, y);
+        int sourceX = map.start;
+        for (int x = 0; x < width; x++) {
+            row[x] = keyframe[sourceX];
+            if (params.animating) row[x].a = 255;
+            sourceX += map.direction;
+            if (sourceX == width) sourceX = 0;
+            else if (sourceX < 0) sourceX = width - 1;
+        }
+    }
+}
@@ -0,0 +1,276 @@
+#include "row_scores.h"
+#include "ingest.h"
+#include "mem_tracker.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h> // For sysconf
+#endif
+
+#define BLOCK_ROWS 64
+#define MAX_THREADS 16
+#define HISTOGRAM_BINS 4096   // 4 bits per channel
+
+// Weights of the normalized metrics in the combined score
+#define WEIGHT_VARIANCE 0.30f
+#define WEIGHT_EDGES    0.30f
+#define WEIGHT_ENTROPY  0.25f
+#define WEIGHT_DISTINCT 0.15f
+
+// Sixteen 16-bit lanes, four RGBA pixels; lowered to SSE/AVX/NEON as available
+#define LANES 16
+typedef uint8_t ByteVector __attribute__((vector_size(LANES)));
+typedef int16_t DiffVector __attribute__((vector_size(LANES * sizeof(int16_t))));
+typedef uint16_t SumVector __attribute__((vector_size(LANES * sizeof(uint16_t))));
+
+// Steps a 16-bit lane can accumulate absolute byte differences without overflow
+#define EDGE_FLUSH_STEPS 256
+
+struct RowScores {
+  Image image;
+  const float *rowVariance;   // Borrowed, or NULL to compute it here
+  RowScore *rows;
+  int *ranking;
+  int rankCount;
+  float *countLog;            // c * log2(c) for every possible bin count
+
+  atomic_int nextBlock;
+  atomic_int rowsDone;
+  atomic_bool ready;
+  atomic_bool cancel;
+
+  pthread_t threads[MAX_THREADS];
+  int threadCount;
+};
+
+static int RowScores_ThreadCount(void) {
+#ifdef _WIN32
+  const char *cpus = getenv("NUMBER_OF_PROCESSORS");
+  int count = (cpus != NULL) ? atoi(cpus) : 1;
+#else
+  int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (count < 1) count = 1;
+  return (count > MAX_THREADS) ? MAX_THREADS : count;
+}
+
+// Sum over x of |p[x+1] - p[x]| for R, G and B
+static float RowScores_EdgeEnergy(const Color *row, int width) {
+  const uint8_t *bytes = (const uint8_t *)row;
+  int count = (width - 1) * 4;
+  DiffVector alphaMask = { -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0 };
+  uint64_t total = 0;
+  int i = 0;
+
+  while (i + LANES <= count) {
+    SumVector sum = { 0 };
+    for (int step = 0; step < EDGE_FLUSH_STEPS && i + LANES <= count; step++, i += LANES) {
+      ByteVector a, b;
+      memcpy(&a, bytes + i, LANES);
+      memcpy(&b, bytes + i + 4, LANES);
+      DiffVector d = __builtin_convertvector(b, DiffVector) - __builtin_convertvector(a, DiffVector);
+      DiffVector sign = d >> 15;
+      sum += (SumVector)(((d ^ sign) - sign) & alphaMask);
+    }
+    for (int lane = 0; lane < LANES; lane++) total += sum[lane];
+  }
+  for (; i < count; i++) {
+    if ((i & 3) != 3) total += abs(bytes[i + 4] - bytes[i]);
+  }
+  return (width > 1) ? (float)total / (width - 1) : 0.0f;
+}
+
+// Entropy and occupied bins of the 4-4-4 histogram; only touched bins are cleared
+static void RowScores_Histogram(const RowScores *scores, const Color *row, int width, uint32_t *histogram,
+                                uint16_t *touched, RowScore *out) {
+  int used = 0;
+  for (int x = 0; x < width; x++) {
+    int bin = ((row[x].r >> 4) << 8) | ((row[x].g >> 4) << 4) | (row[x].b >> 4);
+    if (histogram[bin]++ == 0) touched[used++] = (uint16_t)bin;
+  }
+
+  // H = log2(N) - sum(c * log2(c)) / N
+  float sum = 0.0f;
+  for (int i = 0; i < used; i++) {
+    sum += scores->countLog[histogram[touched[i]]];
+    histogram[touched[i]] = 0;
+  }
+  out->entropy = log2f((float)width) - sum / width;
+  out->distinctColors = (float)used;
+}
+
+typedef struct {
+  float score;
+  int y;
+} RankedRow;
+
+static int RowScores_CompareRanked(const void *a, const void *b) {
+  const RankedRow *x = a, *y = b;
+  if (x->score != y->score) return (x->score < y->score) ? 1 : -1;
+  return x->y - y->y;
+}
+
+// Scales each metric by its maximum, combines them and ranks the rows
+static void RowScores_Finalize(RowScores *scores) {
+  int height = scores->image.height;
+  RowScore max = { 0 };
+  for (int y = 0; y < height; y++) {
+    const RowScore *row = &scores->rows[y];
+    if (row->variance > max.variance) max.variance = row->variance;
+    if (row->edgeEnergy > max.edgeEnergy) max.edgeEnergy = row->edgeEnergy;
+    if (row->entropy > max.entropy) max.entropy = row->entropy;
+    if (row->distinctColors > max.distinctColors) max.distinctColors = row->distinctColors;
+  }
+  for (int y = 0; y < height; y++) {
+    RowScore *row = &scores->rows[y];
+    row->variance = (max.variance > 0.0f) ? row->variance / max.variance : 0.0f;
+    row->edgeEnergy = (max.edgeEnergy > 0.0f) ? row->edgeEnergy / max.edgeEnergy : 0.0f;
+    row->entropy = (max.entropy > 0.0f) ? row->entropy / max.entropy : 0.0f;
+    row->distinctColors = (max.distinctColors > 0.0f) ? row->distinctColors / max.distinctColors : 0.0f;
+    row->score = WEIGHT_VARIANCE * row->variance + WEIGHT_EDGES * row->edgeEnergy +
+                 WEIGHT_ENTROPY * row->entropy + WEIGHT_DISTINCT * row->distinctColors;
+  }
+
+  // Exact scores, best first; ties go to the upper row so the order is stable
+  RankedRow *sorted = malloc(height * sizeof(RankedRow));
+  bool *taken = calloc(height, sizeof(bool));
+  if (sorted == NULL || taken == NULL) {
+    free(sorted); free(taken);
+    return;
+  }
+  for (int y = 0; y < height; y++) sorted[y] = (RankedRow){ scores->rows[y].score, y };
+  qsort(sorted, height, sizeof(RankedRow), RowScores_CompareRanked);
+
+  // Keep a row only if no better row was kept within the suppression radius
+  int radius = (height / 100 > 1) ? height / 100 : 1;
+  for (int i = 0; i < height; i++) {
+    int y = sorted[i].y;
+    if (taken[y]) continue;
+    scores->ranking[scores->rankCount++] = y;
+    int from = (y - radius > 0) ? y - radius : 0;
+    int to = (y + radius < height - 1) ? y + radius : height - 1;
+    for (int n = from; n <= to; n++) taken[n] = true;
+  }
+  free(sorted);
+  free(taken);
+}
+
+static void *RowScores_Worker(void *arg) {
+  RowScores *scores = arg;
+  int width = scores->image.width;
+  int height = scores->image.height;
+  uint32_t *histogram = calloc(HISTOGRAM_BINS, sizeof(uint32_t));
+  uint16_t *touched = malloc(HISTOGRAM_BINS * sizeof(uint16_t));
+  float *variance = (scores->rowVariance == NULL) ? malloc(BLOCK_ROWS * sizeof(float)) : NULL;
+  if (histogram == NULL || touched == NULL || (scores->rowVariance == NULL && variance == NULL)) {
+    free(histogram); free(touched); free(variance);
+    return NULL;
+  }
+
+  for (;;) {
+    if (atomic_load(&scores->cancel)) break;
+    int y0 = atomic_fetch_add(&scores->nextBlock, 1) * BLOCK_ROWS;
+    if (y0 >= height) break;
+    int rows = (y0 + BLOCK_ROWS < height) ? BLOCK_ROWS : height - y0;
+
+    const Color *block = (const Color *)scores->image.data + (size_t)y0 * width;
+    if (variance != NULL) {
+      ComputeRowVariance((Image){ (void *)block, width, rows, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 }, variance);
+    }
+    for (int i = 0; i < rows; i++) {
+      const Color *row = block + (size_t)i * width;
+      RowScore *out = &scores->rows[y0 + i];
+      out->variance = (variance != NULL) ? variance[i] : scores->rowVariance[y0 + i];
+      out->edgeEnergy = RowScores_EdgeEnergy(row, width);
+      RowScores_Histogram(scores, row, width, histogram, touched, out);
+    }
+
+    // Whoever completes the last block ranks the rows for everyone
+    if (atomic_fetch_add(&scores->rowsDone, rows) + rows == height) {
+      RowScores_Finalize(scores);
+      atomic_store(&scores->ready, true);
+    }
+  }
+
+  free(histogram);
+  free(touched);
+  free(variance);
+  return NULL;
+}
+
+// Starts scoring in the background. `image` and `rowVariance` (optional,
+// one entry per row as from ComputeRowVariance) must outlive the engine.
+RowScores *RowScores_Start(Image image, const float *rowVariance) {
+  RowScores *scores = calloc(1, sizeof(RowScores));
+  if (scores == NULL) {
+    return NULL;
+  }
+  scores->image = image;
+  scores->rowVariance = rowVariance;
+  scores->rows = TrackedCalloc(MEM_SOURCE, image.height, sizeof(RowScore));
+  scores->ranking = TrackedMalloc(MEM_SOURCE, image.height * sizeof(int));
+  scores->countLog = TrackedMalloc(MEM_SOURCE, ((size_t)image.width + 1) * sizeof(float));
+  if (scores->rows == NULL || scores->ranking == NULL || scores->countLog == NULL) {
+    TrackedFree(scores->rows);
+    TrackedFree(scores->ranking);
+    TrackedFree(scores->countLog);
+    free(scores);
+    return NULL;
+  }
+  scores->countLog[0] = 0.0f;
+  for (int c = 1; c <= image.width; c++) scores->countLog[c] = c * log2f((float)c);
+  atomic_init(&scores->nextBlock, 0);
+  atomic_init(&scores->rowsDone, 0);
+  atomic_init(&scores->ready, false);
+  atomic_init(&scores->cancel, false);
+
+  int blocks = (image.height + BLOCK_ROWS - 1) / BLOCK_ROWS;
+  int wanted = RowScores_ThreadCount();
+  if (wanted > blocks) wanted = blocks;
+  for (int i = 0; i < wanted; i++) {
+    if (pthread_create(&scores->threads[scores->threadCount], NULL, RowScores_Worker, scores) == 0) scores->threadCount++;
+  }
+  if (scores->threadCount == 0) {
+    // No threads available; score on the caller instead
+    RowScores_Worker(scores);
+  }
+  return scores;
+}
+
+bool RowScores_Ready(const RowScores *scores) {
+  return scores != NULL && atomic_load((atomic_bool *)&scores->ready);
+}
+
+float RowScores_Progress(const RowScores *scores) {
+  if (scores == NULL || scores->image.height == 0) return 0.0f;
+  return (float)atomic_load((atomic_int *)&scores->rowsDone) / scores->image.height;
+}
+
+// Per-row metrics, valid once RowScores_Ready() returns true
+const RowScore *RowScores_Get(const RowScores *scores) {
+  return RowScores_Ready(scores) ? scores->rows : NULL;
+}
+
+int RowScores_RankCount(const RowScores *scores) {
+  return RowScores_Ready(scores) ? scores->rankCount : 0;
+}
+
+// Source row at `rank` (0 is best), or -1 before ready or out of range
+int RowScores_RowAtRank(const RowScores *scores, int rank) {
+  if (!RowScores_Ready(scores) || rank < 0 || rank >= scores->rankCount) return -1;
+  return scores->ranking[rank];
+}
+
+void RowScores_Exit(RowScores *scores) {
+  if (scores == NULL) return;
+  atomic_store(&scores->cancel, true);
+  for (int i = 0; i < scores->threadCount; i++) pthread_join(scores->threads[i], NULL);
+  TrackedFree(scores->rows);
+  TrackedFree(scores->ranking);
+  TrackedFree(scores->countLog);
+  free(scores);
+}
@@ -0,0 +1,330 @@
+#include "raylib.h"
+#include "rlgl.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Offscreen benchmark for the project's fragment shaders. Each shader is drawn
+// into a RenderTexture2D at a sweep of resolutions with no vsync or frame
+// limiter. GPU time comes from GL_TIME_ELAPSED queries; wall time around a
+// glFinish() is always recorded too, and is the only number on drivers
+// without timer queries. Results are written as JSON.
+//
+// Runs on Mesa llvmpipe without a GPU:
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./shader_bench --out shader_bench.json
+
+// Timer query entry points are not exposed by raylib, and libraylib need not
+// export the GLFW or glad symbols it embeds. Load them with the platform's GL
+// loader instead, from the GL library every target links already (-lGL,
+// opengl32, OpenGL.framework); a missing loader is a link error, not a guess.
+typedef void (*GLProc)(void);
+#if defined(_WIN32)
+  #define GLAPIENTRY __stdcall
+  __declspec(dllimport) GLProc __stdcall wglGetProcAddress(const char *procname);
+  #define GetGLProcAddress(name) wglGetProcAddress(name)
+#elif defined(__APPLE__)
+  #include <dlfcn.h>
+  #define GLAPIENTRY
+  #define GetGLProcAddress(name) ((GLProc)dlsym(RTLD_DEFAULT, name))
+#else
+  #define GLAPIENTRY
+  extern GLProc glXGetProcAddressARB(const unsigned char *procname);
+  #define GetGLProcAddress(name) glXGetProcAddressARB((const unsigned char *)(name))
+#endif
+
+// OpenGL 1.0, exported directly by every GL library
+extern void GLAPIENTRY glFinish(void);
+extern const unsigned char *GLAPIENTRY glGetString(unsigned int name);
+
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_QUERY_RESULT 0x8866
+#define GL_VENDOR 0x1F00
+#define GL_RENDERER 0x1F01
+#define GL_VERSION 0x1F02
+
+typedef void (GLAPIENTRY *GenQueriesProc)(int n, unsigned int *ids);
+typedef void (GLAPIENTRY *DeleteQueriesProc)(int n, const unsigned int *ids);
+typedef void (GLAPIENTRY *BeginQueryProc)(unsigned int target, unsigned int id);
+typedef void (GLAPIENTRY *EndQueryProc)(unsigned int target);
+typedef void (GLAPIENTRY *GetQueryObjectui64vProc)(unsigned int id, unsigned int pname, unsigned long long *params);
+
+typedef struct {
+  GenQueriesProc genQueries;
+  DeleteQueriesProc deleteQueries;
+  BeginQueryProc beginQuery;
+  EndQueryProc endQuery;
+  GetQueryObjectui64vProc getQueryObjectui64v;
+  bool hasTimerQueries;
+} GLTiming;
+
+typedef enum {
+  BENCH_SHADER_SWIRL,   // recreate_view_shader.fs over the source texture
+  BENCH_SHADER_GLOW     // glow_ring.fs over a full-target rectangle
+} BenchShaderKind;
+
+typedef struct {
+  const char *name;
+  const char *path;
+  BenchShaderKind kind;
+} BenchShader;
+
+typedef struct {
+  const char *name;
+  int width;
+  int height;
+} BenchResolution;
+
+typedef struct {
+  double mean;
+  double median;
+  double p95;
+  double min;
+} FrameStats;
+
+static const BenchShader shaders[] = {
+  { "recreate_view_shader", "src/recreate_view_shader.fs", BENCH_SHADER_SWIRL },
+  { "glow_ring", "src/glow_ring.fs", BENCH_SHADER_GLOW },
+};
+
+static const BenchResolution resolutions[] = {
+  { "720p", 1280, 720 },
+  { "1080p", 1920, 1080 },
+  { "1440p", 2560, 1440 },
+  { "4k", 3840, 2160 },
+};
+
+#define SHADER_COUNT (int)(sizeof(shaders) / sizeof(shaders[0]))
+#define RESOLUTION_COUNT (int)(sizeof(resolutions) / sizeof(resolutions[0]))
+#define WARMUP_FRAMES 10
+
+static GLProc LoadGLProc(const char *name) {
+  GLProc proc = GetGLProcAddress(name);
+#if defined(_WIN32)
+  // Some Windows drivers return small sentinel values instead of NULL
+  intptr_t value = (intptr_t)proc;
+  if (value >= -1 && value <= 3) proc = NULL;
+#endif
+  return proc;
+}
+
+static GLTiming LoadGLTiming(void) {
+  GLTiming gl = { 0 };
+  gl.genQueries = (GenQueriesProc)LoadGLProc("glGenQueries");
+  gl.deleteQueries = (DeleteQueriesProc)LoadGLProc("glDeleteQueries");
+  gl.beginQuery = (BeginQueryProc)LoadGLProc("glBeginQuery");
+  gl.endQuery = (EndQueryProc)LoadGLProc("glEndQuery");
+  gl.getQueryObjectui64v = (GetQueryObjectui64vProc)LoadGLProc("glGetQueryObjectui64v");
+  // GLX hands out dispatch stubs for any name, so the context itself must
+  // offer GL_TIME_ELAPSED, which is core since OpenGL 3.3
+  int version = rlGetVersion();
+  bool contextHasQueries = (version == RL_OPENGL_33) || (version == RL_OPENGL_43);
+  gl.hasTimerQueries = contextHasQueries && gl.genQueries && gl.deleteQueries && gl.beginQuery &&
+                       gl.endQuery && gl.getQueryObjectui64v;
+  if (getenv("SHADER_BENCH_NO_QUERIES") != NULL) gl.hasTimerQueries = false;
+  return gl;
+}
+
+static int CompareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Sorts samples in place
+static FrameStats ComputeFrameStats(double *samples, int count) {
+  FrameStats stats = { 0 };
+  if (count == 0) return stats;
+  qsort(samples, count, sizeof(double), CompareDoubles);
+  double sum = 0.0;
+  for (int i = 0; i < count; i++) sum += samples[i];
+  stats.mean = sum / count;
+  stats.median = samples[count / 2];
+  stats.p95 = samples[(int)(0.95 * (count - 1))];
+  stats.min = samples[0];
+  return stats;
+}
+
+static void WriteFrameStats(FILE *file, const char *name, FrameStats stats) {
+  fprintf(file, "\"%s\": { \"mean\": %.4f, \"median\": %.4f, \"p95\": %.4f, \"min\": %.4f }",
+          name, stats.mean, stats.median, stats.p95, stats.min);
+}
+
+static void WriteJsonString(FILE *file, const char *text) {
+  fputc('"', file);
+  for (const char *c = (text != NULL) ? text : "unknown"; *c; c++) {
+    if (*c == '"' || *c == '\\') fputc('\\', file);
+    if ((unsigned char)*c >= 0x20) fputc(*c, file);
+  }
+  fputc('"', file);
+}
+
+static void DrawBenchFrame(const BenchShader *bench, Shader shader, Texture2D source, RenderTexture2D target, int frame) {
+  int width = target.texture.width;
+  int height = target.texture.height;
+
+  // Deterministic time so every run shades the same frames
+  float time = frame / 60.0f;
+  int timeLoc = GetShaderLocation(shader, "u_time");
+  if (timeLoc >= 0) SetShaderValue(shader, timeLoc, &time, SHADER_UNIFORM_FLOAT);
+
+  BeginTextureMode(target);
+    ClearBackground(BLACK);
+    BeginShaderMode(shader);
+      if (bench->kind == BENCH_SHADER_SWIRL) {
+        DrawTexturePro(source, (Rectangle){ 0, 0, (float)source.width, (float)source.height },
+                       (Rectangle){ 0, 0, (float)width, (float)height }, (Vector2){ 0, 0 }, 0.0f, WHITE);
+      } else {
+        DrawRectangle(0, 0, width, height, WHITE);
+      }
+    EndShaderMode();
+  EndTextureMode();
+}
+
+int main(int argc, char *argv[]) {
+  int frames = 200;
+  const char *outPath = "shader_bench.json";
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frames = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+    else {
+      printf("Usage: %s [--frames N] [--out results.json]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (frames < 1) frames = 1;
+
+  // Initialization
+  //--------------------------------------------------------------------------------------
+  // Hidden window for the GL context; nothing is ever presented, so no vsync applies
+  SetConfigFlags(FLAG_WINDOW_HIDDEN);
+  SetTraceLogLevel(LOG_WARNING);
+  InitWindow(64, 64, "Shader Benchmark");
+  SetTargetFPS(0);
+
+  GLTiming gl = LoadGLTiming();
+  const char *renderer = (const char *)glGetString(GL_RENDERER);
+  const char *version = (const char *)glGetString(GL_VERSION);
+  const char *vendor = (const char *)glGetString(GL_VENDOR);
+  printf("Renderer: %s (%s), timer queries: %s\n", renderer ? renderer : "unknown",
+         version ? version : "unknown", gl.hasTimerQueries ? "yes" : "no, wall time only");
+
+  // Same source image the shader view uses, or a generated one if it is missing
+  Texture2D source;
+  if (FileExists("assets/TARGET5.png")) {
+    source = LoadTexture("assets/TARGET5.png");
+  } else {
+    Image checks = GenImageChecked(1024, 1024, 32, 32, DARKGRAY, LIGHTGRAY);
+    source = LoadTextureFromImage(checks);
+    UnloadImage(checks);
+  }
+
+  FILE *out = fopen(outPath, "w");
+  if (out == NULL) {
+    printf("Failed to open %s\n", outPath);
+    UnloadTexture(source);
+    CloseWindow();
+    return 1;
+  }
+
+  double *gpuSamples = malloc(frames * sizeof(double));
+  double *wallSamples = malloc(frames * sizeof(double));
+  unsigned int *queries = malloc(frames * sizeof(unsigned int));
+  //--------------------------------------------------------------------------------------
+
+  fprintf(out, "{\n  \"renderer\": ");
+  WriteJsonString(out, renderer);
+  fprintf(out, ",\n  \"vendor\": ");
+  WriteJsonString(out, vendor);
+  fprintf(out, ",\n  \"version\": ");
+  WriteJsonString(out, version);
+  fprintf(out, ",\n  \"frames\": %d,\n  \"timer_queries\": %s,\n  \"results\": [", frames, gl.hasTimerQueries ? "true" : "false");
+
+  bool first = true;
+  for (int s = 0; s < SHADER_COUNT; s++) {
+    const BenchShader *bench = &shaders[s];
+    Shader shader = LoadShader(0, bench->path);
+    if (shader.id == rlGetShaderIdDefault()) { // raylib falls back to the default shader on errors
+      printf("Skipping %s: failed to load %s\n", bench->name, bench->path);
+      continue;
+    }
+
+    for (int r = 0; r < RESOLUTION_COUNT; r++) {
+      const BenchResolution *resolution = &resolutions[r];
+      RenderTexture2D target = LoadRenderTexture(resolution->width, resolution->height);
+
+      float size[2] = { (float)resolution->width, (float)resolution->height };
+      int resolutionLoc = GetShaderLocation(shader, "u_resolution");
+      if (resolutionLoc >= 0) SetShaderValue(shader, resolutionLoc, size, SHADER_UNIFORM_VEC2);
+      float center[2] = { size[0] / 2.0f, size[1] / 2.0f };
+      int centerLoc = GetShaderLocation(shader, "center");
+      if (centerLoc >= 0) SetShaderValue(shader, centerLoc, center, SHADER_UNIFORM_VEC2);
+
+      // Let the driver compile variants and allocate before timing
+      for (int i = 0; i < WARMUP_FRAMES; i++) DrawBenchFrame(bench, shader, source, target, i);
+      glFinish();
+
+      if (gl.hasTimerQueries) gl.genQueries(frames, queries);
+      for (int i = 0; i < frames; i++) {
+        double start = GetTime();
+        if (gl.hasTimerQueries) gl.beginQuery(GL_TIME_ELAPSED, queries[i]);
+        DrawBenchFrame(bench, shader, source, target, i);
+        if (gl.hasTimerQueries) gl.endQuery(GL_TIME_ELAPSED);
+        glFinish();
+        wallSamples[i] = (GetTime() - start) * 1000.0;
+      }
+
+      // Results are read back only after the run so reading never stalls a frame
+      if (gl.hasTimerQueries) {
+        for (int i = 0; i < frames; i++) {
+          unsigned long long elapsed = 0;
+          gl.getQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+          gpuSamples[i] = elapsed / 1.0e6;
+        }
+        gl.deleteQueries(frames, queries);
+      }
+
+      // Without timer queries there is no GPU time; wall time is never reported in its place
+      FrameStats wall = ComputeFrameStats(wallSamples, frames);
+      FrameStats gpu = gl.hasTimerQueries ? ComputeFrameStats(gpuSamples, frames) : (FrameStats){ 0 };
+      double pixels = (double)resolution->width * resolution->height;
+      if (gl.hasTimerQueries) {
+        printf("%-22s %-6s gpu %8.3f ms  wall %8.3f ms  (median)\n", bench->name, resolution->name,
+               gpu.median, wall.median);
+      } else {
+        printf("%-22s %-6s gpu      n/a     wall %8.3f ms  (median)\n", bench->name, resolution->name,
+               wall.median);
+      }
+
+      fprintf(out, "%s\n    { \"shader\": \"%s\", \"resolution\": \"%s\", \"width\": %d, \"height\": %d,\n      ",
+              first ? "" : ",", bench->name, resolution->name, resolution->width, resolution->height);
+      fprintf(out, "\"gpu_timer\": %s,\n      ", gl.hasTimerQueries ? "true" : "false");
+      if (gl.hasTimerQueries) WriteFrameStats(out, "gpu_ms", gpu);
+      else fprintf(out, "\"gpu_ms\": null");
+      fprintf(out, ",\n      ");
+      WriteFrameStats(out, "wall_ms", wall);
+      if (gl.hasTimerQueries && gpu.median > 0.0) {
+        fprintf(out, ",\n      \"mpix_per_s\": %.1f }", pixels / (gpu.median * 1000.0));
+      } else {
+        fprintf(out, ",\n      \"mpix_per_s\": null }");
+      }
+      first = false;
+
+      UnloadRenderTexture(target);
+    }
+    UnloadShader(shader);
+  }
+  fprintf(out, "\n  ]\n}\n");
+  fclose(out);
+  printf("Results written to %s\n", outPath);
+
+  // De-Initialization
+  //--------------------------------------------------------------------------------------
+  free(gpuSamples);
+  free(wallSamples);
+  free(queries);
+  UnloadTexture(source);
+  CloseWindow();
+  //--------------------------------------------------------------------------------------
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include "shm_output.h"
+#include "mem_tracker.h"
+#include "shm_ring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+struct ShmOutput {
+  char name[256];
+  unsigned char *base;
+  size_t mappingSize;
+  ShmRingHeader *header;
+  uint64_t nextFrame;
+};
+
+static ShmSlotHeader *ShmOutput_Slot(ShmOutput *output, uint64_t index) {
+  return (ShmSlotHeader *)(output->base + output->header->firstSlotOffset + index * output->header->slotStride);
+}
+
+ShmOutput *ShmOutput_Open(const char *name, int width, int height, int slotCount) {
+  ShmOutput *output = calloc(1, sizeof(ShmOutput));
+  if (output == NULL) {
+    return NULL;
+  }
+
+  // Slots are cache-line aligned so neighbouring seq counters never share a line
+  uint64_t frameBytes = (uint64_t)width * height * 4;
+  uint64_t firstSlotOffset = (sizeof(ShmRingHeader) + 63) & ~(uint64_t)63;
+  uint64_t slotStride = (sizeof(ShmSlotHeader) + frameBytes + 63) & ~(uint64_t)63;
+  output->mappingSize = firstSlotOffset + slotStride * slotCount;
+  snprintf(output->name, sizeof(output->name), "%s%s", (name[0] == '/') ? "" : "/", name);
+
+  int fd = shm_open(output->name, O_CREAT | O_RDWR, 0644);
+  if (fd < 0 || ftruncate(fd, (off_t)output->mappingSize) != 0) {
+    printf("Failed to create shared memory %s\n", output->name);
+    if (fd >= 0) close(fd);
+    free(output);
+    return NULL;
+  }
+  output->base = mmap(NULL, output->mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (output->base == MAP_FAILED) {
+    shm_unlink(output->name);
+    free(output);
+    return NULL;
+  }
+
+  // Readers check the magic last, so it is written after everything else
+  // Every slot gets written, so the whole ring ends up resident and dirty
+  TrackBytes(MEM_SHARED, (long long)output->mappingSize);
+
+  output->header = (ShmRingHeader *)output->base;
+  memset(output->base, 0, firstSlotOffset);
+  output->header->version = SHM_RING_VERSION;
+  output->header->slotCount = (uint32_t)slotCount;
+  output->header->width = (uint32_t)width;
+  output->header->height = (uint32_t)height;
+  output->header->format = SHM_FORMAT_RGBA8;
+  output->header->frameBytes = frameBytes;
+  output->header->slotStride = slotStride;
+  output->header->firstSlotOffset = firstSlotOffset;
+  atomic_store(&output->header->published, 0);
+  for (int i = 0; i < slotCount; i++) {
+    atomic_store(&ShmOutput_Slot(output, i)->seq, 0);
+  }
+  atomic_thread_fence(memory_order_release);
+  output->header->magic = SHM_RING_MAGIC;
+
+  printf("Publishing %dx%d frames to shared memory %s (%d slots)\n", width, height, output->name, slotCount);
+  return output;
+}
+
+void ShmOutput_Publish(ShmOutput *output, const Color *pixels) {
+  if (output == NULL) {
+    return;
+  }
+
+  ShmSlotHeader *slot = ShmOutput_Slot(output, output->nextFrame % output->header->slotCount);
+  uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+  atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  slot->frameIndex = output->nextFrame;
+  slot->timestampNs = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+  slot->size = output->header->frameBytes;
+  memcpy((unsigned char *)SHM_SLOT_PIXELS(slot), pixels, output->header->frameBytes);
+
+  atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+  atomic_store_explicit(&output->header->published, ++output->nextFrame, memory_order_release);
+}
+
+void ShmOutput_Close(ShmOutput *output) {
+  if (output == NULL) {
+    return;
+  }
+
+  munmap(output->base, output->mappingSize);
+  TrackBytes(MEM_SHARED, -(long long)output->mappingSize);
+  shm_unlink(output->name);
+  free(output);
+}
+
+#else // _WIN32
+
+ShmOutput *ShmOutput_Open(const char *name, int width, int height, int slotCount) {
+  (void)width; (void)height; (void)slotCount;
+  printf("Shared memory output (%s) is not supported on Windows\n", name);
+  return NULL;
+}
+
+void ShmOutput_Publish(ShmOutput *output, const Color *pixels) { (void)output; (void)pixels; }
+void ShmOutput_Close(ShmOutput *output) { (void)output; }
+
+#endif
@@ -1,6 +1,118 @@
 #include "view_analyzer.h"
+#include "keyframe_timeline.h"
+#include "mem_tracker.h"
+#include "recreation.h"
+#include "row_scores.h"
 #include "raylib.h"
 #include <stdio.h>
+#include <string.h> // For memcpy
+
+//----------------------------------------------------------------------------------
+// Module Local Functions Definition
+//----------------------------------------------------------------------------------
+// Returns the source row or column under the bar as a contiguous run of pixels.
+// Columns come from the transposed copy, so both axes read sequential memory.
+static const Color *GetScanline(AppState *state, int *length)
+{
+    if (state->scanAxis == SCAN_VERTICAL) {
+        float xScale = (float)state->original.width / (float)state->finalWidth;
+        int sourceX = (int)((state->barX - state->posX) * xScale);
+        if (sourceX < 0 || sourceX >= state->original.width) return NULL;
+        *length = state->original.height;
+        return (const Color *)state->transposed.data + (size_t)sourceX * state->original.height;
+    }
+
+    // A ranked row is used as is; on a downscaled image several source rows
+    // share the bar's display row, and mapping back could pick a neighbour
+    float yScale = (float)state->original.height / (float)state->finalHeight;
+    int sourceY = (state->selectedRow >= 0) ? state->selectedRow : (int)((state->barY - state->posY) * yScale);
+    if (sourceY < 0 || sourceY >= state->original.height) return NULL;
+    *length = state->original.width;
+    return (const Color *)state->original.data + (size_t)sourceY * state->original.width;
+}
+
+// Steps through the row-score ranking and moves the bar onto that source row
+static void JumpToRankedRow(AppState *state, int step)
+{
+    int count = RowScores_RankCount(state->rowScores);
+    if (count == 0) return;
+    state->scoreRank = (state->scoreRank < 0) ? 0 : ((state->scoreRank + step) % count + count) % count;
+
+    int row = RowScores_RowAtRank(state->rowScores, state->scoreRank);
+    if (row < 0) return;
+    float yScale = (float)state->original.height / (float)state->finalHeight;
+    state->scanAxis = SCAN_HORIZONTAL;
+    state->barY = state->posY + (row + 0.5f) / yScale;
+    state->selectedRow = row;
+    state->manualControl = true; // Keep the mouse from moving the bar off the row
+}
+
+// Draws each display row's best source-row score in the strip between the
+// image and the plot, with the currently selected ranked row marked
+static void DrawScoreCurve(AppState *state)
+{
+    float stripX = (float)(state->posX + state->finalWidth + 4);
+    float stripWidth = 36.0f;
+    if (!RowScores_Ready(state->rowScores)) {
+        if (state->rowScores != NULL) {
+            DrawText(TextFormat("%d%%", (int)(RowScores_Progress(state->rowScores) * 100.0f)), (int)stripX, state->posY, 10, GRAY);
+        }
+        return;
+    }
+
+    const RowScore *scores = RowScores_Get(state->rowScores);
+    int height = state->original.height;
+    Vector2 previous = { 0 };
+    for (int dy = 0; dy < state->finalHeight; dy++) {
+        int from = (int)((long long)dy * height / state->finalHeight);
+        int to = (int)((long long)(dy + 1) * height / state->finalHeight);
+        float best = scores[from].score;
+        for (int y = from + 1; y < to; y++) if (scores[y].score > best) best = scores[y].score;
+
+        Vector2 point = { stripX + best * stripWidth, (float)(state->posY + dy) };
+        if (dy > 0) DrawLineV(previous, point, ORANGE);
+        previous = point;
+    }
+
+    if (state->scoreRank >= 0) {
+        int row = RowScores_RowAtRank(state->rowScores, state->scoreRank);
+        float y = state->posY + (row + 0.5f) * state->finalHeight / (float)height;
+        DrawTriangle((Vector2){ stripX + stripWidth + 6, y - 5 }, (Vector2){ stripX + stripWidth, y }, (Vector2){ stripX + stripWidth + 6, y + 5 }, YELLOW);
+        DrawText(TextFormat("#%d", state->scoreRank + 1), (int)stripX, (int)y + 6, 10, YELLOW);
+    }
+}
+
+// Whether a line can be captured into the timeline being built. A timeline
+// already handed to the recreate view is replaced, so anything goes then.
+static bool TimelineAccepts(AppState *state, int length, bool vertical)
+{
+    if (state->keyframeTimeline == NULL || state->timelineComplete) return true;
+    if (KeyframeTimeline_Matches(state->keyframeTimeline, length, vertical)) return true;
+
+    printf("Keyframe rejected: the timeline holds %s of %d pixels. Finish it with [K] on a matching %s first.\n",
+           vertical ? "rows" : "columns", (vertical ? state->original.width : state->original.height),
+           vertical ? "row" : "column");
+    return false;
+}
+
+// Adds a scanline to the keyframe timeline, starting a fresh one after the
+// previous timeline was handed to the recreate view. Keyframes sit at the
+// animation time they were captured at, so playback follows the pace of the
+// captures, unless a fixed spacing was configured.
+static void AddTimelineKeyframe(AppState *state, const Color *scanline, int length, bool vertical)
+{
+    if (state->timelineComplete) {
+        KeyframeTimeline_Clear(state->keyframeTimeline);
+        state->timelineComplete = false;
+    }
+    int count = KeyframeTimeline_Count(state->keyframeTimeline);
+    if (count == 0) state->timelineStartTime = GetTime();
+    float time = (state->keyframeSpacing > 0.0f) ? count * state->keyframeSpacing
+                                                 : (float)((GetTime() - state->timelineStartTime) * state->clock.speed);
+    if (!KeyframeTimeline_Append(state->keyframeTimeline, scanline, length, vertical, time)) {
+        printf("Failed to add keyframe to timeline!\n");
+    }
+}
 
 //----------------------------------------------------------------------------------
 // Module Functions Definition
@@ -12,25 +124,45 @@ void UpdateAnalyzerView(AppState *state)
     // Mouse vs Keyboard control
     if (mousePosition.x != state->lastMousePosition.x || mousePosition.y != state->lastMousePosition.y) {
         state->manualControl = false;
+        state->selectedRow = -1;
         state->upKeyDownTime = 0.0;
         state->downKeyDownTime = 0.0;
     }
     state->lastMousePosition = mousePosition;
 
+    // Scan axis
+    if (IsKeyPressed(KEY_V)) {
+        state->scanAxis = (state->scanAxis == SCAN_HORIZONTAL) ? SCAN_VERTICAL : SCAN_HORIZONTAL;
+        state->selectedRow = -1;
+    }
+    bool vertical = (state->scanAxis == SCAN_VERTICAL);
+    float *bar = vertical ? &state->barX : &state->barY;
+    int decreaseKey = vertical ? KEY_LEFT : KEY_UP;
+    int increaseKey = vertical ? KEY_RIGHT : KEY_DOWN;
+
     // Key holds for accelerated movement
-    if (IsKeyPressed(KEY_UP)) { state->manualControl = true; state->barY -= 1; state->upKeyDownTime = GetTime(); }
-    if (IsKeyDown(KEY_UP) && state->upKeyDownTime > 0.0) { if ((GetTime() - state->upKeyDownTime) > 0.5) state->barY -= 100.0f * GetFrameTime(); }
-    if (IsKeyReleased(KEY_UP)) state->upKeyDownTime = 0.0;
+    if (IsKeyPressed(decreaseKey)) { state->manualControl = true; state->selectedRow = -1; *bar -= 1; state->upKeyDownTime = GetTime(); }
+    if (IsKeyDown(decreaseKey) && state->upKeyDownTime > 0.0) { if ((GetTime() - state->upKeyDownTime) > 0.5) *bar -= 100.0f * GetFrameTime(); }
+    if (IsKeyReleased(decreaseKey)) state->upKeyDownTime = 0.0;
 
-    if (IsKeyPressed(KEY_DOWN)) { state->manualControl = true; state->barY += 1; state->downKeyDownTime = GetTime(); }
-    if (IsKeyDown(KEY_DOWN) && state->downKeyDownTime > 0.0) { if ((GetTime() - state->downKeyDownTime) > 0.5) state->barY += 100.0f * GetFrameTime(); }
-    if (IsKeyReleased(KEY_DOWN)) state->downKeyDownTime = 0.0;
+    if (IsKeyPressed(increaseKey)) { state->manualControl = true; state->selectedRow = -1; *bar += 1; state->downKeyDownTime = GetTime(); }
+    if (IsKeyDown(increaseKey) && state->downKeyDownTime > 0.0) { if ((GetTime() - state->downKeyDownTime) > 0.5) *bar += 100.0f * GetFrameTime(); }
+    if (IsKeyReleased(increaseKey)) state->downKeyDownTime = 0.0;
 
-    if (!state->manualControl) state->barY = mousePosition.y;
+    if (!state->manualControl) *bar = vertical ? mousePosition.x : mousePosition.y;
 
-    // Clamp bar position
+    // Jump between the best-scoring rows
+    if (IsKeyPressed(KEY_N)) {
+        bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+        JumpToRankedRow(state, shift ? -1 : 1);
+    }
+    if (IsKeyPressed(KEY_B)) JumpToRankedRow(state, -1);
+
+    // Clamp bar positions
     if (state->barY < state->posY) state->barY = state->posY;
     if (state->barY > state->posY + state->finalHeight - 1) state->barY = state->posY + state->finalHeight - 1;
+    if (state->barX < state->posX) state->barX = state->posX;
+    if (state->barX > state->posX + state->finalWidth - 1) state->barX = state->posX + state->finalWidth - 1;
 
     // Button clicks
     if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
@@ -44,28 +176,38 @@ void UpdateAnalyzerView(AppState *state)
         }
     }
 
-    // Keyframe capture
+    // Timeline keyframe: add the current line and keep scanning
+    if (IsKeyPressed(KEY_J) && state->keyframeTimeline != NULL) {
+        int length = 0;
+        const Color *scanline = GetScanline(state, &length);
+        if (scanline != NULL && TimelineAccepts(state, length, vertical)) AddTimelineKeyframe(state, scanline, length, vertical);
+    }
+
+    // Keyframe capture: the current line ends the timeline, if one was started
     if (IsKeyPressed(KEY_K)) {
-        float yScale = (float)state->original.height / (float)state->finalHeight;
-        int sourceY = (int)((state->barY - state->posY) * yScale);
-        if (sourceY >= 0 && sourceY < state->original.height) {
-            Color *sourceData = (Color *)state->original.data;
-            for (int x = 0; x < state->original.width; x++) {
-                state->keyframe_pixels[x] = sourceData[sourceY * state->original.width + x];
+        int length = 0;
+        const Color *scanline = GetScanline(state, &length);
+        if (scanline != NULL && TimelineAccepts(state, length, vertical)) {
+            memcpy(state->keyframe_pixels, scanline, length * sizeof(Color));
+            state->keyframe_vertical = vertical;
+            if (state->keyframeTimeline != NULL) {
+                AddTimelineKeyframe(state, scanline, length, vertical);
+                state->timelineComplete = true;
+                if (KeyframeTimeline_Count(state->keyframeTimeline) > 1) {
+                    state->t = 0.0f; // Play the timeline from its first keyframe
+                    KeyframeTimeline_Sample(state->keyframeTimeline, state->t, state->keyframe_pixels);
+                }
             }
 
             // Regenerate the recreation image with the new keyframe
-            Color *newPixels = (Color *)state->recreationImage.data;
-            for (int y = 0; y < state->recreationImage.height; y++) {
-                bool reversed = ((y / state->stripe_height) % 2 != 0);
-                for (int x = 0; x < state->recreationImage.width; x++) {
-                    int sourceX = reversed ? (state->recreationImage.width - 1 - x) : x;
-                    newPixels[y * state->recreationImage.width + x] = state->keyframe_pixels[sourceX];
-                }
-            }
-            
-            if (state->recreationTexture.id > 0) UnloadTexture(state->recreationTexture);
+            RecreationParams params = { 0.0f, 0, state->stripe_height, false, state->keyframe_vertical };
+            GenerateRecreationFrame(state->keyframe_pixels, state->recreationImage.width, state->recreationImage.height,
+                                    params, (Color *)state->recreationImage.data);
+
+            if (state->recreationTexture.id > 0) { UntrackTexture(state->recreationTexture); UnloadTexture(state->recreationTexture); }
             state->recreationTexture = LoadTextureFromImage(state->recreationImage);
+            TrackTexture(state->recreationTexture);
+            AnimClock_Resume(&state->clock, GetTime());
             state->currentView = VIEW_RECREATE;
             SetWindowSize(1000, 800);
         }
@@ -89,50 +231,52 @@ void DrawAnalyzerView(AppState *state)
         }
 
         // Draw Plot Area
+        bool vertical = (state->scanAxis == SCAN_VERTICAL);
         DrawRectangleLinesEx(state->plotArea, 1, WHITE);
-        DrawText("X-Coordinate", state->plotArea.x + state->plotArea.width/2 - 50, state->plotArea.y + state->plotArea.height + 10, 20, WHITE);
-        DrawText("Value", state->plotArea.x - 60, state->plotArea.y + state->plotArea.height/2 - 10, 20, WHITE);
+        DrawText(vertical ? "Y-Coordinate" : "X-Coordinate", state->plotArea.x + state->plotArea.width/2 - 50, state->plotArea.y + state->plotArea.height + 10, 20, WHITE);
+        DrawText("Value", state->plotArea.x, state->plotArea.y - 20, 20, WHITE); // Left of the plot is the score strip
+        DrawScoreCurve(state);
 
         // Draw hover bar and plot
         if (CheckCollisionPointRec(mousePosition, imageBounds) || state->manualControl) {
-            DrawRectangle(state->posX, (int)state->barY - 1, state->finalWidth, 1, GREEN);
+            if (vertical) DrawRectangle((int)state->barX - 1, state->posY, 1, state->finalHeight, GREEN);
+            else DrawRectangle(state->posX, (int)state->barY - 1, state->finalWidth, 1, GREEN);
 
-            float yScale = (float)state->original.height / (float)state->finalHeight;
-            int sourceY = (int)((state->barY - state->posY) * yScale);
+            int length = 0;
+            const Color *scanline = GetScanline(state, &length);
 
-            if (sourceY >= 0 && sourceY < state->original.height) {
+            if (scanline != NULL) {
                 if (state->currentChannel == CHANNEL_ORIGINAL) {
                     Vector2 prevR = {0}, prevG = {0}, prevB = {0};
-                    Color *sourceData = (Color *)state->original.data;
-                    for (int x = 0; x < state->original.width; x++) {
-                        Color p = sourceData[sourceY * state->original.width + x];
-                        float plotX = state->plotArea.x + ((float)x / (state->original.width - 1)) * state->plotArea.width;
+                    for (int i = 0; i < length; i++) {
+                        Color p = scanline[i];
+                        float plotX = state->plotArea.x + ((float)i / (length - 1)) * state->plotArea.width;
                         Vector2 curR = { plotX, state->plotArea.y + state->plotArea.height - (((float)p.r / 255.0f) * state->plotArea.height) };
                         Vector2 curG = { plotX, state->plotArea.y + state->plotArea.height - (((float)p.g / 255.0f) * state->plotArea.height) };
                         Vector2 curB = { plotX, state->plotArea.y + state->plotArea.height - (((float)p.b / 255.0f) * state->plotArea.height) };
-                        if (x > 0) { DrawLineV(prevR, curR, RED); DrawLineV(prevG, curG, GREEN); DrawLineV(prevB, curB, BLUE); }
+                        if (i > 0) { DrawLineV(prevR, curR, RED); DrawLineV(prevG, curG, GREEN); DrawLineV(prevB, curB, BLUE); }
                         prevR = curR; prevG = curG; prevB = curB;
                     }
                 } else {
+                    // Channel images hold the same channel values as the original
                     Vector2 prevPoint = { 0 };
                     Color plotColor = RED;
-                    Color *sourceData = NULL;
                     switch (state->currentChannel) {
-                        case CHANNEL_R: sourceData = (Color *)state->r_img.data; plotColor = RED; break;
-                        case CHANNEL_G: sourceData = (Color *)state->g_img.data; plotColor = GREEN; break;
-                        case CHANNEL_B: sourceData = (Color *)state->b_img.data; plotColor = BLUE; break;
+                        case CHANNEL_R: plotColor = RED; break;
+                        case CHANNEL_G: plotColor = GREEN; break;
+                        case CHANNEL_B: plotColor = BLUE; break;
                         default: break;
                     }
-                    for (int x = 0; x < state->original.width; x++) {
+                    for (int i = 0; i < length; i++) {
                         unsigned char value = 0;
                         switch (state->currentChannel) {
-                            case CHANNEL_R: value = sourceData[sourceY * state->original.width + x].r; break;
-                            case CHANNEL_G: value = sourceData[sourceY * state->original.width + x].g; break;
-                            case CHANNEL_B: value = sourceData[sourceY * state->original.width + x].b; break;
+                            case CHANNEL_R: value = scanline[i].r; break;
+                            case CHANNEL_G: value = scanline[i].g; break;
+                            case CHANNEL_B: value = scanline[i].b; break;
                             default: break;
                         }
-                        Vector2 currentPoint = { state->plotArea.x + ((float)x / (state->original.width - 1)) * state->plotArea.width, state->plotArea.y + state->plotArea.height - (((float)value / 255.0f) * state->plotArea.height) };
-                        if (x > 0) DrawLineV(prevPoint, currentPoint, plotColor);
+                        Vector2 currentPoint = { state->plotArea.x + ((float)i / (length - 1)) * state->plotArea.width, state->plotArea.y + state->plotArea.height - (((float)value / 255.0f) * state->plotArea.height) };
+                        if (i > 0) DrawLineV(prevPoint, currentPoint, plotColor);
                         prevPoint = currentPoint;
                     }
                 }
@@ -145,7 +289,10 @@ void DrawAnalyzerView(AppState *state)
         DrawRectangleRec(state->bButton, (state->currentChannel == CHANNEL_B) ? DARKBLUE : DARKGRAY); DrawText("B", state->bButton.x + 15, state->bButton.y + 5, 20, WHITE);
         DrawRectangleRec(state->originalButton, (state->currentChannel == CHANNEL_ORIGINAL) ? PURPLE : DARKGRAY); DrawText("Orig", state->originalButton.x + 15, state->originalButton.y + 5, 20, WHITE);
         DrawRectangleRec(state->shadermodeButton, (state->currentView == VIEW_RECREATE_SHADER) ? PURPLE : DARKGRAY); DrawText("Shader", state->shadermodeButton.x + 15, state->shadermodeButton.y + 5, 20, WHITE);
-        DrawText("Press [K] to Keyframe", 360, 15, 20, WHITE);
+        DrawText(vertical ? "Press [K] to Keyframe, [V] for rows" : "Press [K] to Keyframe, [V] for columns", 360, 15, 20, WHITE);
+        int timelineCount = (state->keyframeTimeline != NULL && !state->timelineComplete) ? KeyframeTimeline_Count(state->keyframeTimeline) : 0;
+        DrawText(TextFormat("[J] Add to timeline (%d keyframes)   [N]/[B] Next/previous best row", timelineCount), 360, 40, 20, LIGHTGRAY);
         DrawFPS(1300, 10);
+        if (state->showMemoryOverlay) DrawMemoryOverlay(1180, 40);
     EndDrawing();
 }
@@ -1,4 +1,11 @@
 #include "view_recreate.h"
+#include "frame_pipeline.h"
+#include "frame_store.h"
+#include "keyframe_timeline.h"
+#include "mem_tracker.h"
+#include "recreation.h"
+#include "shm_output.h"
+#include "y4m_writer.h"
 #include "raylib.h"
 #include <stdio.h> // For TextFormat
 #include <stdlib.h> // For malloc/free
@@ -7,7 +14,11 @@
 //----------------------------------------------------------------------------------
 // Module Local Functions Declaration
 //----------------------------------------------------------------------------------
+static RecreationParams CurrentRecreationParams(AppState *state);
+static bool TimelineActive(AppState *state);
 static void RegenerateRecreationImage(AppState *state);
+static void PresentRecreationFrame(AppState *state, const Color *pixels);
+static void TogglePipelinedMode(AppState *state);
 static void StartVideoRecording(AppState *state);
 static void StopVideoRecording(AppState *state);
 static void CaptureFrame(AppState *state);
@@ -30,9 +41,14 @@ void UpdateRecreateView(AppState *state)
     // Toggle animation
     if (IsKeyPressed(KEY_SPACE)) {
         state->animating = !state->animating;
+        if (state->animating) AnimClock_Resume(&state->clock, GetTime());
     }
 
     // Video recording controls
+    if (IsKeyPressed(KEY_Y) && !state->recording) {
+        state->recordFormat = (state->recordFormat == RECORD_FORMAT_PNG) ? RECORD_FORMAT_Y4M : RECORD_FORMAT_PNG;
+        printf("Recording format: %s\n", (state->recordFormat == RECORD_FORMAT_Y4M) ? "Y4M" : "PNG + ffmpeg");
+    }
     if (IsKeyPressed(KEY_R)) {
         if (!state->recording) {
             StartVideoRecording(state);
@@ -41,11 +57,40 @@ void UpdateRecreateView(AppState *state)
         }
     }
 
-    // Update t if animating
+    // Toggle pipelined generation
+    if (IsKeyPressed(KEY_P)) {
+        if (state->resumePipelined) printf("Pipelined generation stays off until the recording stops\n");
+        else TogglePipelinedMode(state);
+    }
+
+    // Toggle how timeline keyframes blend into each other
+    if (IsKeyPressed(KEY_T) && TimelineActive(state)) {
+        KeyframeBlendMode mode = (KeyframeTimeline_GetBlendMode(state->keyframeTimeline) == KEYFRAME_BLEND_CROSSFADE) ? KEYFRAME_BLEND_SWEEP : KEYFRAME_BLEND_CROSSFADE;
+        KeyframeTimeline_SetBlendMode(state->keyframeTimeline, mode);
+        printf("Timeline blend: %s\n", (mode == KEYFRAME_BLEND_SWEEP) ? "sweep" : "crossfade");
+    }
+
+    // Present the newest frame the worker finished while we were drawing the last one
+    if (state->pipelined) {
+        const Color *frame = FramePipeline_Acquire(state->framePipeline, NULL);
+        if (frame != NULL) PresentRecreationFrame(state, frame);
+    }
+
+    // Advance t by the clock; frames that are not due are never generated
+    bool frameDue = false;
+    state->captureDue = false;
     if (state->animating) {
-        state->t += state->dt;
-        RegenerateRecreationImage(state); // Regenerate on each frame for animation
-        UpdateTexture(state->recreationTexture, state->recreationImage.data);
+        float previousT = state->t;
+        bool advanced = AnimClock_Advance(&state->clock, GetTime(), &state->t);
+        state->captureDue = advanced && state->recording;
+        // Stripes only move on whole steps of t, timeline blends move continuously
+        frameDue = advanced && ((int)state->t != (int)previousT || TimelineActive(state));
+        // One line-sized blend per frame; the stripe renderer expands it as usual
+        if (frameDue && TimelineActive(state)) KeyframeTimeline_Sample(state->keyframeTimeline, state->t, state->keyframe_pixels);
+        if (frameDue && !state->pipelined) {
+            RegenerateRecreationImage(state);
+            PresentRecreationFrame(state, state->recreationImage.data);
+        }
     }
 
     // Handle LEFT key
@@ -80,10 +125,15 @@ void UpdateRecreateView(AppState *state)
         state->rightKeyDownTime = 0.0;
     }
 
+    // Hand the next frame to the worker; it is generated while this one is drawn
+    if (state->pipelined && (frameDue || z_changed)) {
+        FramePipeline_Submit(state->framePipeline, state->keyframe_pixels, CurrentRecreationParams(state));
+    }
+
     // If Z changed, regenerate the image data and update the GPU texture
-    if (z_changed && !state->animating) { // Avoid double-update when animating
+    if (z_changed && !frameDue && !state->pipelined) { // Avoid double-update when animating
         RegenerateRecreationImage(state);
-        UpdateTexture(state->recreationTexture, state->recreationImage.data);
+        PresentRecreationFrame(state, state->recreationImage.data);
     }
 }
 
@@ -95,11 +145,12 @@ void DrawRecreateView(AppState *state)
             DrawTexturePro(state->recreationTexture, (Rectangle){ 0, 0, (float)state->recreationTexture.width, (float)state->recreationTexture.height },
                            (Rectangle){ 0, 0, 1000, 800 }, (Vector2){ 0, 0 }, 0.0f, WHITE);
         }
+        if (state->showMemoryOverlay) DrawMemoryOverlay(790, 10);
         
     EndDrawing();
     
-    // Capture frame if recording
-    if (state->recording && state->animating) {
+    // Capture frame if the recording clock produced one
+    if (state->recording && state->captureDue) {
         CaptureFrame(state);
     }
 }
@@ -107,65 +158,41 @@ void DrawRecreateView(AppState *state)
 //----------------------------------------------------------------------------------
 // Module Local Functions Definition
 //----------------------------------------------------------------------------------
-static unsigned char get_animated_r(AppState *state, int x, bool reversed) {
-    int width = state->recreationImage.width;
-    int sourceX_r;
-    if (reversed) {
-        sourceX_r = ((x + state->z_offset - (int)state->t) % width + width) % width;
-    } else {
-        sourceX_r = ((x + state->z_offset + (int)state->t) % width + width) % width;
-    }
-    return state->keyframe_pixels[sourceX_r].r;
+static RecreationParams CurrentRecreationParams(AppState *state)
+{
+    return (RecreationParams){ state->t, state->z_offset, state->stripe_height, state->animating, state->keyframe_vertical };
 }
 
-static unsigned char get_animated_g(AppState *state, int x, bool reversed) {
-    int width = state->recreationImage.width;
-    int sourceX_g;
-    if (reversed) {
-        sourceX_g = ((x + state->z_offset - (int)state->t) % width + width) % width;
-    } else {
-        sourceX_g = ((x + state->z_offset + (int)state->t) % width + width) % width;
-    }
-    return state->keyframe_pixels[sourceX_g].g;
+// A timeline with a single keyframe is just the plain keyframe
+static bool TimelineActive(AppState *state)
+{
+    return state->keyframeTimeline != NULL && state->timelineComplete && KeyframeTimeline_Count(state->keyframeTimeline) > 1;
 }
 
-static unsigned char get_animated_b(AppState *state, int x, bool reversed) {
-    int width = state->recreationImage.width;
-    int sourceX_b;
-    if (reversed) {
-        sourceX_b = ((x + state->z_offset - (int)state->t) % width + width) % width;
-    } else {
-        sourceX_b = ((x + state->z_offset + (int)state->t) % width + width) % width;
-    }
-    return state->keyframe_pixels[sourceX_b].b;
+static void RegenerateRecreationImage(AppState *state)
+{
+    GenerateRecreationFrame(state->keyframe_pixels, state->recreationImage.width, state->recreationImage.height,
+                            CurrentRecreationParams(state), (Color *)state->recreationImage.data);
 }
 
-static void RegenerateRecreationImage(AppState *state)
+// Uploads a finished frame and hands it to any shared-memory readers
+static void PresentRecreationFrame(AppState *state, const Color *pixels)
 {
-    Color *newPixels = (Color *)state->recreationImage.data;
-    int width = state->recreationImage.width;
-    int height = state->recreationImage.height;
+    UpdateTexture(state->recreationTexture, pixels);
+    ShmOutput_Publish(state->shmOutput, pixels);
+}
 
-    for (int y = 0; y < height; y++) {
-        bool reversed = ((y / state->stripe_height) % 2 != 0);
-        for (int x = 0; x < width; x++) {
-            Color *pixel = &newPixels[y * width + x];
-            if (state->animating) {
-                pixel->r = get_animated_r(state, x, reversed);
-                pixel->g = get_animated_g(state, x, reversed);
-                pixel->b = get_animated_b(state, x, reversed);
-                pixel->a = 255;
-            } else {
-                int sourceX;
-                if (reversed) {
-                    sourceX = ( ( (width - 1 - x) + state->z_offset) % width + width ) % width;
-                } else {
-                    sourceX = x;
-                }
-                *pixel = state->keyframe_pixels[sourceX];
-            }
+static void TogglePipelinedMode(AppState *state)
+{
+    if (!state->pipelined && state->framePipeline == NULL) {
+        state->framePipeline = FramePipeline_Init(state->recreationImage.width, state->recreationImage.height);
+        if (state->framePipeline == NULL) {
+            printf("Failed to start frame pipeline!\n");
+            return;
         }
     }
+    state->pipelined = !state->pipelined;
+    printf("Pipelined generation %s\n", state->pipelined ? "enabled" : "disabled");
 }
 
 //----------------------------------------------------------------------------------
@@ -179,12 +206,16 @@ static void StartVideoRecording(AppState *state)
     state->recording = true;
     state->frame_count = 0;
     
-    // Allocate frame buffer
-    state->frame_buffer = (Image *)malloc(state->max_frames * sizeof(Image));
-    if (!state->frame_buffer) {
-        printf("Failed to allocate frame buffer!\n");
-        state->recording = false;
-        return;
+    if (state->recordFormat == RECORD_FORMAT_Y4M) {
+        // Y4M frames are written as they are captured, no frame buffer needed
+        state->y4mWriter = Y4mWriter_Open("animation_output.y4m", state->recreationImage.width, state->recreationImage.height, RECORD_FPS);
+        if (!state->y4mWriter) {
+            printf("Failed to open animation_output.y4m!\n");
+            state->recording = false;
+            return;
+        }
+        int keyframeLength = GetRecreationKeyframeLength(CurrentRecreationParams(state), state->recreationImage.width, state->recreationImage.height);
+        Y4mWriter_SetKeyframe(state->y4mWriter, state->keyframe_pixels, keyframeLength);
     }
     
     // Start animation if not already running
@@ -192,6 +223,15 @@ static void StartVideoRecording(AppState *state)
         state->animating = true;
         state->t = 0.0f; // Reset animation time
     }
+    // Screen captures must show the frame for the clock's t. A pipelined frame
+    // can lag behind by one or more steps, so generate synchronously instead.
+    if (state->recordFormat == RECORD_FORMAT_PNG && state->pipelined) {
+        state->pipelined = false;
+        state->resumePipelined = true;
+        printf("Pipelined generation paused while recording\n");
+    }
+    // Every captured frame advances t by exactly 1/RECORD_FPS of animation time
+    AnimClock_StartFixedStep(&state->clock, RECORD_FPS, GetTime());
     
     printf("Video recording started. Press R again to stop.\n");
 }
@@ -202,20 +242,28 @@ static void StopVideoRecording(AppState *state)
     
     printf("Stopping video recording...\n");
     state->recording = false;
+    AnimClock_StartRealtime(&state->clock, GetTime());
+    if (state->resumePipelined) {
+        state->pipelined = true;
+        state->resumePipelined = false;
+        printf("Pipelined generation resumed\n");
+    }
     
-    if (state->frame_count > 0) {
+    if (state->y4mWriter) {
+        Y4mWriter_Close(state->y4mWriter);
+        state->y4mWriter = NULL;
+        printf("Video written: animation_output.y4m (%d frames)\n", state->frame_count);
+    }
+    
+    if (state->frameStore && state->frame_count > 0) {
         printf("Captured %d frames. Exporting video...\n", state->frame_count);
+        FrameStore_PrintStats(state->frameStore);
         ExportFramesToVideo(state);
     }
     
-    // Cleanup frame buffer
-    if (state->frame_buffer) {
-        for (int i = 0; i < state->frame_count; i++) {
-            UnloadImage(state->frame_buffer[i]);
-        }
-        free(state->frame_buffer);
-        state->frame_buffer = NULL;
-    }
+    // Cleanup frame store
+    FrameStore_Exit(state->frameStore);
+    state->frameStore = NULL;
     
     state->frame_count = 0;
     printf("Video recording stopped.\n");
@@ -223,33 +271,90 @@ static void StopVideoRecording(AppState *state)
 
 static void CaptureFrame(AppState *state)
 {
-    if (!state->recording || !state->frame_buffer) return;
-    if (state->frame_count >= state->max_frames) {
+    if (!state->recording) return;
+    
+    // Stripe frames go straight to YUV; no screen capture or RGB conversion per frame
+    if (state->y4mWriter) {
+        // The keyframe changes under a timeline and when it is recaptured in the
+        // analyzer mid-recording; converting one line per frame costs next to nothing
+        int keyframeLength = GetRecreationKeyframeLength(CurrentRecreationParams(state), state->recreationImage.width, state->recreationImage.height);
+        Y4mWriter_SetKeyframe(state->y4mWriter, state->keyframe_pixels, keyframeLength);
+        if (!Y4mWriter_WriteStripeFrame(state->y4mWriter, CurrentRecreationParams(state))) {
+            printf("Failed to write Y4M frame. Stopping recording.\n");
+            StopVideoRecording(state);
+            return;
+        }
+        state->frame_count++;
+        return;
+    }
+    
+    if (state->max_frames > 0 && state->frame_count >= state->max_frames) {
         printf("Maximum frames reached. Stopping recording.\n");
         StopVideoRecording(state);
         return;
     }
+    size_t screenBytes = (size_t)GetScreenWidth() * GetScreenHeight() * 4;
+    if (!MemoryBudgetAllows(screenBytes) && state->frameStore &&
+        FrameStore_SetMemoryHighWater(state->frameStore, 0)) {
+        // Degrade first: keep recording, but stream every sealed segment to disk
+        printf("Memory budget reached. Spilling recorded frames to disk.\n");
+    }
+    if (!MemoryBudgetAllows(screenBytes)) {
+        printf("Memory budget reached. Stopping recording.\n");
+        StopVideoRecording(state);
+        return;
+    }
     
-    // Capture the current screen
-    state->frame_buffer[state->frame_count] = LoadImageFromScreen();
-    state->frame_count++;
+    // Capture the current screen and compress it into the frame store
+    Image screen = LoadImageFromScreen();
+    if (!state->frameStore) {
+        // Compressed frames above this many MB are spilled to a temp file
+        const char *storeEnv = getenv("RECREATE_FRAME_STORE_MB");
+        size_t storeMB = (storeEnv != NULL) ? (size_t)strtoul(storeEnv, NULL, 10) : 256;
+        size_t highWater = storeMB * 1024 * 1024;
+
+        // Never plan to hold more than half of what the budget has left
+        size_t budget = GetMemoryBudget();
+        if (budget > 0) {
+            size_t used = GetTrackedTotal();
+            size_t headroom = (used < budget) ? (budget - used) / 2 : 0;
+            if (highWater > headroom) highWater = headroom;
+        }
+        state->frameStore = FrameStore_Init(screen.width, screen.height, highWater);
+    }
+    if (state->frameStore && FrameStore_Append(state->frameStore, screen)) {
+        state->frame_count++;
+    } else {
+        printf("Failed to store frame %d.\n", state->frame_count);
+    }
+    UnloadImage(screen);
 }
 
 static void ExportFramesToVideo(AppState *state)
 {
-    if (!state->frame_buffer || state->frame_count == 0) return;
+    if (!state->frameStore || state->frame_count == 0) return;
     
     // Create frames directory
     char command[512];
     snprintf(command, sizeof(command), "mkdir -p %s", state->recording_dir);
     system(command);
     
-    // Export frames as PNG files
+    // Export frames as PNG files, decompressing one frame at a time
     printf("Exporting %d frames to %s/\n", state->frame_count, state->recording_dir);
+    if (!FrameStore_BeginRead(state->frameStore)) {
+        printf("Failed to read back recorded frames. Nothing exported.\n");
+        return;
+    }
     for (int i = 0; i < state->frame_count; i++) {
+        Image frame = FrameStore_ReadNext(state->frameStore);
+        if (frame.data == NULL) {
+            // Every stored frame should decode; a gap means the spill file or memory failed
+            printf("Failed to read back frame %d of %d. The video is truncated.\n", i + 1, state->frame_count);
+            break;
+        }
         char filename[512];
         snprintf(filename, sizeof(filename), "%s/frame_%06d.png", state->recording_dir, i);
-        ExportImage(state->frame_buffer[i], filename);
+        ExportImage(frame, filename);
         
         if (i % 30 == 0) { // Progress indicator every 30 frames
             printf("Exported frame %d/%d\n", i + 1, state->frame_count);
@@ -259,8 +364,8 @@ static void ExportFramesToVideo(AppState *state)
     // Generate ffmpeg command
     char ffmpeg_cmd[1024];
     snprintf(ffmpeg_cmd, sizeof(ffmpeg_cmd), 
-        "ffmpeg -y -framerate 30 -i %s/frame_%%06d.png -c:v libx264 -pix_fmt yuv420p -crf 18 animation_output.mp4",
-        state->recording_dir);
+        "ffmpeg -y -framerate %d -i %s/frame_%%06d.png -c:v libx264 -pix_fmt yuv420p -crf 18 animation_output.mp4",
+        RECORD_FPS, state->recording_dir);
     
     printf("\nFrames exported successfully!\n");
     printf("To create the video, run this command:\n");
@@ -284,5 +389,20 @@ static void ExportFramesToVideo(AppState *state)
     } else {
         printf("ffmpeg command failed. You can manually run the command above.\n");
         printf("Make sure ffmpeg is installed and in your PATH.\n");
+        
+        // Still produce a playable file without ffmpeg
+        Image frame = FrameStore_BeginRead(state->frameStore) ? FrameStore_ReadNext(state->frameStore) : (Image){ 0 };
+        Y4mWriter *writer = (frame.data != NULL) ? Y4mWriter_Open("animation_output.y4m", frame.width, frame.height, RECORD_FPS) : NULL;
+        if (writer) {
+            int written = 0;
+            for (; frame.data != NULL; frame = FrameStore_ReadNext(state->frameStore)) {
+                if (Y4mWriter_WriteImage(writer, frame)) written++;
+            }
+            Y4mWriter_Close(writer);
+            printf("Wrote %d frames to animation_output.y4m instead.\n", written);
+            if (written < state->frame_count) {
+                printf("Only %d of %d frames could be read back and written. The video is truncated.\n", written, state->frame_count);
+            }
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "y4m_writer.h"
+#include "mem_tracker.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// BT.601 limited range, 8-bit fixed point
+#define RGB_TO_Y(r, g, b) (((66 * (r) + 129 * (g) + 25 * (b) + 128) >> 8) + 16)
+#define RGB_TO_U(r, g, b) (((-38 * (r) - 74 * (g) + 112 * (b) + 128) >> 8) + 128)
+#define RGB_TO_V(r, g, b) (((112 * (r) - 94 * (g) - 18 * (b) + 128) >> 8) + 128)
+
+// Eight lanes of 32-bit math; GCC and Clang lower this to SSE/AVX/NEON as available
+#define LANES 8
+typedef int32_t LaneVector __attribute__((vector_size(LANES * sizeof(int32_t))));
+
+struct Y4mWriter {
+  FILE *file;
+  int width;
+  int height;
+  int chromaWidth;
+  int chromaHeight;
+
+  // Output planes for the frame being assembled
+  uint8_t *planeY;
+  uint8_t *planeU;
+  uint8_t *planeV;
+
+  // Keyframe line converted to YUV, one entry per source pixel
+  uint8_t *keyY;
+  uint8_t *keyU;
+  uint8_t *keyV;
+  int *rowIndices[2];
+};
+
+// Frees the planes and the writer; safe on a partially opened writer
+static void Y4mWriter_FreeBuffers(Y4mWriter *writer) {
+  TrackedFree(writer->planeY);
+  TrackedFree(writer->planeU);
+  TrackedFree(writer->planeV);
+  TrackedFree(writer->keyY);
+  TrackedFree(writer->keyU);
+  TrackedFree(writer->keyV);
+  TrackedFree(writer->rowIndices[0]);
+  TrackedFree(writer->rowIndices[1]);
+  free(writer);
+}
+
+// Writes the frame last built into the planes
+bool Y4mWriter_WriteFrame(Y4mWriter *writer) {
+  size_t lumaSize = (size_t)writer->width * writer->height;
+  size_t chromaSize = (size_t)writer->chromaWidth * writer->chromaHeight;
+  if (fputs("FRAME\n", writer->file) == EOF) return false;
+  if (fwrite(writer->planeY, 1, lumaSize, writer->file) != lumaSize) return false;
+  if (fwrite(writer->planeU, 1, chromaSize, writer->file) != chromaSize) return false;
+  if (fwrite(writer->planeV, 1, chromaSize, writer->file) != chromaSize) return false;
+  return true;
+}
+
+// Converts a pair of RGBA rows to one luma row each and one shared chroma row
+static void Y4mWriter_ConvertRowPair(Y4mWriter *writer, const Color *row0, const Color *row1,
+                                     uint8_t *lumaRow0, uint8_t *lumaRow1, uint8_t *chromaU, uint8_t *chromaV) {
+  int width = writer->width;
+  int x = 0;
+
+  // Vectorized body: LANES output pixels per row, LANES / 2 chroma samples
+  for (; x + LANES <= width; x += LANES) {
+    LaneVector r0, g0, b0, r1, g1, b1;
+    for (int i = 0; i < LANES; i++) {
+      r0[i] = row0[x + i].r; g0[i] = row0[x + i].g; b0[i] = row0[x + i].b;
+      r1[i] = row1[x + i].r; g1[i] = row1[x + i].g; b1[i] = row1[x + i].b;
+    }
+    LaneVector y0 = ((66 * r0 + 129 * g0 + 25 * b0 + 128) >> 8) + 16;
+    LaneVector y1 = ((66 * r1 + 129 * g1 + 25 * b1 + 128) >> 8) + 16;
+
+    // Vertical sums, then horizontal pairs
+    LaneVector rs = r0 + r1, gs = g0 + g1, bs = b0 + b1;
+    LaneVector u = -38 * rs - 74 * gs + 112 * bs;
+    LaneVector v = 112 * rs - 94 * gs - 18 * bs;
+    for (int i = 0; i < LANES; i++) {
+      lumaRow0[x + i] = (uint8_t)y0[i];
+      lumaRow1[x + i] = (uint8_t)y1[i];
+    }
+    for (int i = 0; i < LANES; i += 2) {
+      chromaU[(x + i) / 2] = (uint8_t)(((u[i] + u[i + 1] + 512) >> 10) + 128);
+      chromaV[(x + i) / 2] = (uint8_t)(((v[i] + v[i + 1] + 512) >> 10) + 128);
+    }
+  }
+
+  // Scalar tail, replicating the last column when the width is odd
+  for (; x < width; x += 2) {
+    int x1 = (x + 1 < width) ? x + 1 : x;
+    Color p00 = row0[x], p01 = row0[x1], p10 = row1[x], p11 = row1[x1];
+    lumaRow0[x] = (uint8_t)RGB_TO_Y(p00.r, p00.g, p00.b);
+    lumaRow1[x] = (uint8_t)RGB_TO_Y(p10.r, p10.g, p10.b);
+    if (x1 != x) {
+      lumaRow0[x1] = (uint8_t)RGB_TO_Y(p01.r, p01.g, p01.b);
+      lumaRow1[x1] = (uint8_t)RGB_TO_Y(p11.r, p11.g, p11.b);
+    }
+    int r = p00.r + p01.r + p10.r + p11.r;
+    int g = p00.g + p01.g + p10.g + p11.g;
+    int b = p00.b + p01.b + p10.b + p11.b;
+    chromaU[x / 2] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128);
+    chromaV[x / 2] = (uint8_t)(((112 * r - 94 * g - 18 * b + 512) >> 10) + 128);
+  }
+}
+
+Y4mWriter *Y4mWriter_Open(const char *path, int width, int height, int fps) {
+  Y4mWriter *writer = calloc(1, sizeof(Y4mWriter));
+  if (writer == NULL) {
+    return NULL;
+  }
+
+  writer->file = fopen(path, "wb");
+  if (writer->file == NULL) {
+    free(writer);
+    return NULL;
+  }
+  writer->width = width;
+  writer->height = height;
+  writer->chromaWidth = (width + 1) / 2;
+  writer->chromaHeight = (height + 1) / 2;
+
+  writer->planeY = TrackedMalloc(MEM_RECREATION, (size_t)width * height);
+  writer->planeU = TrackedMalloc(MEM_RECREATION, (size_t)writer->chromaWidth * writer->chromaHeight);
+  writer->planeV = TrackedMalloc(MEM_RECREATION, (size_t)writer->chromaWidth * writer->chromaHeight);
+  int keyframeCapacity = (width > height) ? width : height;
+  writer->keyY = TrackedMalloc(MEM_RECREATION, keyframeCapacity);
+  writer->keyU = TrackedMalloc(MEM_RECREATION, keyframeCapacity);
+  writer->keyV = TrackedMalloc(MEM_RECREATION, keyframeCapacity);
+  writer->rowIndices[0] = TrackedMalloc(MEM_RECREATION, width * sizeof(int));
+  writer->rowIndices[1] = TrackedMalloc(MEM_RECREATION, width * sizeof(int));
+  if (writer->planeY == NULL || writer->planeU == NULL || writer->planeV == NULL ||
+      writer->keyY == NULL || writer->keyU == NULL || writer->keyV == NULL ||
+      writer->rowIndices[0] == NULL || writer->rowIndices[1] == NULL) {
+    fclose(writer->file);
+    Y4mWriter_FreeBuffers(writer);
+    return NULL;
+  }
+
+  fprintf(writer->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", width, height, fps);
+  return writer;
+}
+
+// Converts the keyframe line to YUV; stripe frames only ever gather from it
+void Y4mWriter_SetKeyframe(Y4mWriter *writer, const Color *keyframe, int length) {
+  for (int x = 0; x < length; x++) {
+    Color p = keyframe[x];
+    writer->keyY[x] = (uint8_t)RGB_TO_Y(p.r, p.g, p.b);
+    writer->keyU[x] = (uint8_t)RGB_TO_U(p.r, p.g, p.b);
+    writer->keyV[x] = (uint8_t)RGB_TO_V(p.r, p.g, p.b);
+  }
+}
+
+// Assembles a stripe frame into the planes without writing it
+void Y4mWriter_BuildStripeFrame(Y4mWriter *writer, RecreationParams params) {
+  int width = writer->width;
+  int height = writer->height;
+  RecreationRowMap previous[2] = { { -1, 0 }, { -1, 0 } };
+
+  for (int cy = 0; cy < writer->chromaHeight; cy++) {
+    int y0 = 2 * cy;
+    int y1 = (y0 + 1 < height) ? y0 + 1 : y0;
+    uint8_t *chromaU = &writer->planeU[cy * writer->chromaWidth];
+    uint8_t *chromaV = &writer->planeV[cy * writer->chromaWidth];
+
+    // Row pairs inside a horizontal stripe repeat the previous pair exactly.
+    // Vertical stripes change along x, so no pair ever repeats there.
+    if (!params.vertical) {
+      RecreationRowMap map0 = GetRecreationRowMap(params, width, y0);
+      RecreationRowMap map1 = GetRecreationRowMap(params, width, y1);
+      bool repeat = (cy > 0) &&
+                    map0.start == previous[0].start && map0.direction == previous[0].direction &&
+                    map1.start == previous[1].start && map1.direction == previous[1].direction;
+      if (repeat) {
+        memcpy(&writer->planeY[y0 * width], &writer->planeY[(y0 - 2) * width], width);
+        if (y1 != y0) memcpy(&writer->planeY[y1 * width], &writer->planeY[(y1 - 2) * width], width);
+        memcpy(chromaU, chromaU - writer->chromaWidth, writer->chromaWidth);
+        memcpy(chromaV, chromaV - writer->chromaWidth, writer->chromaWidth);
+        continue;
+      }
+      previous[0] = map0;
+      previous[1] = map1;
+    }
+
+    int *indices0 = writer->rowIndices[0];
+    int *indices1 = writer->rowIndices[1];
+    GetRecreationRowIndices(params, width, height, y0, indices0);
+    GetRecreationRowIndices(params, width, height, y1, indices1);
+
+    uint8_t *lumaRow0 = &writer->planeY[y0 * width];
+    uint8_t *lumaRow1 = &writer->planeY[y1 * width];
+    for (int x = 0; x < width; x++) {
+      lumaRow0[x] = writer->keyY[indices0[x]];
+      lumaRow1[x] = writer->keyY[indices1[x]];
+    }
+    for (int cx = 0; cx < writer->chromaWidth; cx++) {
+      int x0 = 2 * cx;
+      int x1 = (x0 + 1 < width) ? x0 + 1 : x0;
+      int u = writer->keyU[indices0[x0]] + writer->keyU[indices0[x1]] + writer->keyU[indices1[x0]] + writer->keyU[indices1[x1]];
+      int v = writer->keyV[indices0[x0]] + writer->keyV[indices0[x1]] + writer->keyV[indices1[x0]] + writer->keyV[indices1[x1]];
+      chromaU[cx] = (uint8_t)((u + 2) >> 2);
+      chromaV[cx] = (uint8_t)((v + 2) >> 2);
+    }
+  }
+}
+
+bool Y4mWriter_WriteStripeFrame(Y4mWriter *writer, RecreationParams params) {
+  Y4mWriter_BuildStripeFrame(writer, params);
+  return Y4mWriter_WriteFrame(writer);
+}
+
+// General fallback for frames that are not plain stripes, e.g. screen captures
+bool Y4mWriter_WriteImage(Y4mWriter *writer, Image image) {
+  if (image.width != writer->width || image.height != writer->height ||
+      image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+    return false;
+  }
+
+  const Color *pixels = (const Color *)image.data;
+  for (int cy = 0; cy < writer->chromaHeight; cy++) {
+    int y0 = 2 * cy;
+    int y1 = (y0 + 1 < writer->height) ? y0 + 1 : y0;
+    Y4mWriter_ConvertRowPair(writer, &pixels[y0 * writer->width], &pixels[y1 * writer->width],
+                             &writer->planeY[y0 * writer->width], &writer->planeY[y1 * writer->width],
+                             &writer->planeU[cy * writer->chromaWidth], &writer->planeV[cy * writer->chromaWidth]);
+  }
+
+  return Y4mWriter_WriteFrame(writer);
+}
+
+void Y4mWriter_Close(Y4mWriter *writer) {
+  if (writer == NULL) {
+    return;
+  }
+
+  fclose(writer->file);
+  Y4mWriter_FreeBuffers(writer);
+}